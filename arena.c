@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/*
+ * Implementation of an arena allocator.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * The arena is a linked list of chunks. Blocks are carved from the
+ * newest chunk by bumping an offset. Block sizes are rounded up to a
+ * multiple of ALIGNMENT, and freed blocks of each rounded size are kept
+ * in a singly linked free list threaded through the blocks themselves.
+ */
+
+// Alignment and size granularity of all blocks.
+#define ALIGNMENT 8
+
+// Default chunk size.
+#define DEFAULT_CHUNK_SIZE (64 * 1024)
+
+// Number of free lists, one per size class.
+#define NUM_CLASSES (ARENA_MAX_CLASS / ALIGNMENT)
+
+struct chunk {
+	struct chunk *next;
+	size_t size;
+	size_t used;
+	// The memory of the chunk follows the header.
+};
+
+struct free_block {
+	struct free_block *next;
+};
+
+struct arena {
+	struct chunk *chunks;
+	size_t chunk_size;
+	struct free_block *free_lists[NUM_CLASSES];
+};
+
+// Size of the chunk header rounded up to keep the blocks aligned.
+#define HEADER_SIZE ((sizeof(struct chunk) + ALIGNMENT - 1) \
+		     & ~(size_t)(ALIGNMENT - 1))
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * round_size() - Round a block size up to the next multiple of ALIGNMENT.
+ * @size: Block size.
+ *
+ * Returns: The rounded size, at least ALIGNMENT.
+ */
+static size_t round_size(size_t size)
+{
+	if (size == 0) {
+		size = 1;
+	}
+	return (size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+}
+
+/**
+ * add_chunk() - Allocate a new chunk and link it into an arena.
+ * @a: Arena to manipulate.
+ * @size: Minimum usable size of the chunk.
+ *
+ * The new chunk becomes the current chunk unless it was allocated for a
+ * single large block, in which case it is linked in after the current one.
+ *
+ * Returns: The new chunk.
+ */
+static struct chunk *add_chunk(arena *a, size_t size)
+{
+	int oversized = size > a->chunk_size;
+	if (!oversized) {
+		size = a->chunk_size;
+	}
+	struct chunk *c = malloc(HEADER_SIZE + size);
+	c->size = size;
+	c->used = 0;
+
+	if (oversized && a->chunks != NULL) {
+		c->next = a->chunks->next;
+		a->chunks->next = c;
+	} else {
+		c->next = a->chunks;
+		a->chunks = c;
+	}
+	return c;
+}
+
+/**
+ * arena_empty() - Create an empty arena.
+ * @chunk_size: Size in bytes of each chunk, or 0 for a default size.
+ *
+ * Returns: A pointer to the new arena.
+ */
+arena *arena_empty(size_t chunk_size)
+{
+	arena *a = calloc(1, sizeof(*a));
+	a->chunk_size = chunk_size > 0 ? round_size(chunk_size)
+		: DEFAULT_CHUNK_SIZE;
+	return a;
+}
+
+/**
+ * arena_alloc() - Allocate a zeroed block of memory from an arena.
+ * @a: Arena to allocate from.
+ * @size: Size of the block in bytes.
+ *
+ * Returns: A pointer to the block, suitably aligned for any pointer or
+ *	    double.
+ */
+void *arena_alloc(arena *a, size_t size)
+{
+	size = round_size(size);
+
+	// Reuse a freed block of the same size class if there is one.
+	if (size <= ARENA_MAX_CLASS) {
+		struct free_block **list = &a->free_lists[size / ALIGNMENT - 1];
+		if (*list != NULL) {
+			struct free_block *b = *list;
+			*list = b->next;
+			memset(b, 0, size);
+			return b;
+		}
+	}
+
+	// Otherwise carve the block from the current chunk.
+	struct chunk *c = a->chunks;
+	if (c == NULL || c->size - c->used < size) {
+		c = add_chunk(a, size);
+	}
+	void *p = (char *)c + HEADER_SIZE + c->used;
+	c->used += size;
+	memset(p, 0, size);
+	return p;
+}
+
+/**
+ * arena_free() - Give a block back to an arena.
+ * @a: Arena the block was allocated from.
+ * @p: Block to give back.
+ * @size: Size of the block, as given to arena_alloc().
+ *
+ * Blocks larger than ARENA_MAX_CLASS bytes are not reused; their memory
+ * is returned by arena_kill().
+ *
+ * Returns: Nothing.
+ */
+void arena_free(arena *a, void *p, size_t size)
+{
+	size = round_size(size);
+	if (p == NULL || size > ARENA_MAX_CLASS) {
+		return;
+	}
+	struct free_block *b = p;
+	b->next = a->free_lists[size / ALIGNMENT - 1];
+	a->free_lists[size / ALIGNMENT - 1] = b;
+}
+
+/**
+ * arena_kill() - Destroy a given arena.
+ * @a: Arena to destroy.
+ *
+ * Return all memory used by the arena, including every block handed
+ * out by it. The cost is proportional to the number of chunks, not the
+ * number of blocks.
+ *
+ * Returns: Nothing.
+ */
+void arena_kill(arena *a)
+{
+	struct chunk *c = a->chunks;
+	while (c != NULL) {
+		struct chunk *next = c->next;
+		free(c);
+		c = next;
+	}
+	free(a);
+}
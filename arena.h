@@ -0,0 +1,69 @@
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Declaration of an arena allocator. The arena hands out small blocks
+ * of memory carved from large chunks, so that data structures with
+ * many small parts (e.g. list cells) need few calls to malloc(). All
+ * memory handed out by an arena is returned at once by arena_kill().
+ * Blocks of up to ARENA_MAX_CLASS bytes that are given back with
+ * arena_free() are kept in per-size free lists and reused by later
+ * calls to arena_alloc().
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Arena type.
+typedef struct arena arena;
+
+// Largest block size that is recycled by arena_free().
+#define ARENA_MAX_CLASS 64
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * arena_empty() - Create an empty arena.
+ * @chunk_size: Size in bytes of each chunk, or 0 for a default size.
+ *
+ * Returns: A pointer to the new arena.
+ */
+arena *arena_empty(size_t chunk_size);
+
+/**
+ * arena_alloc() - Allocate a zeroed block of memory from an arena.
+ * @a: Arena to allocate from.
+ * @size: Size of the block in bytes.
+ *
+ * Returns: A pointer to the block, suitably aligned for any pointer or
+ *	    double.
+ */
+void *arena_alloc(arena *a, size_t size);
+
+/**
+ * arena_free() - Give a block back to an arena.
+ * @a: Arena the block was allocated from.
+ * @p: Block to give back.
+ * @size: Size of the block, as given to arena_alloc().
+ *
+ * Blocks larger than ARENA_MAX_CLASS bytes are not reused; their memory
+ * is returned by arena_kill().
+ *
+ * Returns: Nothing.
+ */
+void arena_free(arena *a, void *p, size_t size);
+
+/**
+ * arena_kill() - Destroy a given arena.
+ * @a: Arena to destroy.
+ *
+ * Return all memory used by the arena, including every block handed
+ * out by it. The cost is proportional to the number of chunks, not the
+ * number of blocks.
+ *
+ * Returns: Nothing.
+ */
+void arena_kill(arena *a);
+
+#endif
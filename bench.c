@@ -0,0 +1,1622 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "graph.h"
+#include "csr.h"
+#include "bfs.h"
+#include "reach_index.h"
+#include "hop_index.h"
+#include "dijkstra.h"
+#include "path.h"
+#include "map.h"
+#include "dlist.h"
+#include "list.h"
+#include "queue.h"
+
+/*
+ * Benchmarks for the graph library. Each benchmark is selected by
+ * name on the command line and prints one line of results per run.
+ *
+ * Usage: bench load [nodes] [edges]
+ *        bench queue [operations]
+ *        bench search [nodes] [edges] [queries]
+ *        bench reach [nodes] [edges] [sources]
+ *        bench threads [nodes] [edges] [sources]
+ *        bench multi [nodes] [edges] [sources]
+ *        bench index [nodes] [edges] [queries]
+ *        bench hop [nodes] [edges] [queries]
+ *        bench route [nodes] [edges] [queries]
+ *        bench map [nodes] [edges]
+ *        bench snap [nodes] [edges]
+ *        bench gen rmat|grid|hub <file> [nodes] [edges]
+ *        bench suite [all|rmat|grid|hub] [nodes] [edges] [queries]
+ *        bench reorder [all|rmat|grid|hub] [nodes] [edges] [sources]
+ */
+
+// Largest graph for which the quadratic list scan baseline is run.
+#define MAX_SCAN_NODES 50000
+
+// Largest thread count of the parallel BFS scaling benchmark.
+#define MAX_THREADS 16
+
+// Number of index queries that are checked against csr_find_path().
+#define CHECKED_QUERIES 200
+
+// Largest edge weight of the route benchmark.
+#define MAX_WEIGHT 100
+
+// Number of find_path() searches timed by the benchmark suite.
+#define SUITE_PATHS 100
+
+// ===========INTERNAL DATA TYPES============
+
+// Name/node pair used by the list scan baseline.
+struct entry {
+	char *name;
+	node *n;
+};
+
+// Synthetic graph generator. Returns 2*count node indices, the edges.
+struct generator {
+	const char *name;
+	int *(*make)(int num_nodes, int num_edges, int *count);
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * now() - Return a monotonic time stamp.
+ *
+ * Returns: The current time in seconds.
+ */
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/**
+ * rnd() - Return the next value from a xorshift generator.
+ * @state: Generator state, must be non-zero.
+ *
+ * Returns: A pseudo-random number.
+ */
+static unsigned int rnd(unsigned int *state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/**
+ * make_names() - Create the node names N0, N1, ...
+ * @n: Number of names.
+ *
+ * Returns: An array of n names. Free with free_names().
+ */
+static char **make_names(int n)
+{
+	char **names = malloc(n * sizeof(*names));
+	for (int i = 0; i < n; i++) {
+		names[i] = malloc(16);
+		sprintf(names[i], "N%d", i);
+	}
+	return names;
+}
+
+/**
+ * free_names() - Free names created by make_names().
+ * @names: Names to free.
+ * @n: Number of names.
+ *
+ * Returns: Nothing.
+ */
+static void free_names(char **names, int n)
+{
+	for (int i = 0; i < n; i++) {
+		free(names[i]);
+	}
+	free(names);
+}
+
+/**
+ * scan_find() - Find a node by scanning a list of name/node pairs,
+ *		 the way graph_find_node() used to work.
+ * @l: List of struct entry.
+ * @s: Name to find.
+ *
+ * Returns: The node, or NULL.
+ */
+static node *scan_find(const dlist *l, const char *s)
+{
+	dlist_pos pos = dlist_first(l);
+	while (!dlist_is_end(l, pos)) {
+		struct entry *e = dlist_inspect(l, pos);
+		if (strncmp(e->name, s, strlen(s) + 1) == 0) {
+			return e->n;
+		}
+		pos = dlist_next(l, pos);
+	}
+	return NULL;
+}
+
+/**
+ * load_edges() - Build a graph from an edge list the way map_load() does.
+ * @names: Node names.
+ * @edges: Edge list, 2*num_edges node indices.
+ * @num_edges: Number of edges.
+ * @scan: If true, look up nodes by list scan instead of graph_find_node().
+ * @t_kill: Set to the time in seconds needed by graph_kill().
+ *
+ * Returns: The time in seconds needed to build the graph.
+ */
+static double load_edges(char **names, const int *edges, int num_edges,
+			 bool scan, double *t_kill)
+{
+	dlist *entries = dlist_empty(free);
+	double t0 = now();
+	graph *g = graph_empty(2 * num_edges);
+
+	for (int i = 0; i < num_edges; i++) {
+		node *ends[2];
+		for (int k = 0; k < 2; k++) {
+			char *s = names[edges[2 * i + k]];
+			ends[k] = scan ? scan_find(entries, s)
+				: graph_find_node(g, s);
+			if (ends[k] == NULL) {
+				graph_insert_node(g, s);
+				ends[k] = graph_find_node(g, s);
+				if (scan) {
+					struct entry *e = malloc(sizeof(*e));
+					e->name = s;
+					e->n = ends[k];
+					dlist_insert(entries, e,
+						     dlist_first(entries));
+				}
+			}
+		}
+		graph_insert_edge(g, ends[0], ends[1]);
+	}
+
+	double t = now() - t0;
+	t0 = now();
+	graph_kill(g);
+	*t_kill = now() - t0;
+	dlist_kill(entries);
+	return t;
+}
+
+/**
+ * bench_load() - Compare map loading with hashed and scanned node lookup.
+ * @num_nodes: Number of distinct node names.
+ * @num_edges: Number of edges to insert.
+ *
+ * Returns: Nothing.
+ */
+static void bench_load(int num_nodes, int num_edges)
+{
+	unsigned int state = 12345;
+	char **names = make_names(num_nodes);
+	int *edges = malloc(2 * num_edges * sizeof(*edges));
+	for (int i = 0; i < 2 * num_edges; i++) {
+		edges[i] = rnd(&state) % num_nodes;
+	}
+
+	double t_kill;
+	double t_hash = load_edges(names, edges, num_edges, false, &t_kill);
+	if (num_nodes <= MAX_SCAN_NODES) {
+		double t_scan = load_edges(names, edges, num_edges, true,
+					   &t_kill);
+		printf("load nodes=%d edges=%d scan=%.4fs hash=%.4fs "
+		       "speedup=%.1f kill=%.4fs\n", num_nodes, num_edges,
+		       t_scan, t_hash, t_scan / t_hash, t_kill);
+	} else {
+		// the quadratic baseline would take hours at this size
+		printf("load nodes=%d edges=%d scan=skipped hash=%.4fs "
+		       "kill=%.4fs\n", num_nodes, num_edges, t_hash, t_kill);
+	}
+
+	free(edges);
+	free_names(names, num_nodes);
+}
+
+/**
+ * run_queue() - Time a fill/drain and a steady state run of the queue.
+ * @n: Number of elements to enqueue in each run.
+ * @t_fill: Time for enqueueing n elements and then dequeueing them.
+ * @t_steady: Time for n enqueue/dequeue pairs on a queue of 64 elements.
+ *
+ * Returns: Nothing.
+ */
+static void run_queue(int n, double *t_fill, double *t_steady)
+{
+	queue *q = queue_empty(NULL);
+	double t0 = now();
+	for (int i = 0; i < n; i++) {
+		queue_enqueue(q, &q);
+	}
+	while (!queue_is_empty(q)) {
+		queue_front(q);
+		queue_dequeue(q);
+	}
+	*t_fill = now() - t0;
+
+	for (int i = 0; i < 64; i++) {
+		queue_enqueue(q, &q);
+	}
+	t0 = now();
+	for (int i = 0; i < n; i++) {
+		queue_enqueue(q, &q);
+		queue_front(q);
+		queue_dequeue(q);
+	}
+	*t_steady = now() - t0;
+	queue_kill(q);
+}
+
+/**
+ * run_list_queue() - Like run_queue(), but using a list as the queue the
+ *		      way the list-backed queue implementation did.
+ * @n: Number of elements to enqueue in each run.
+ * @t_fill: Time for enqueueing n elements and then dequeueing them.
+ * @t_steady: Time for n enqueue/dequeue pairs on a queue of 64 elements.
+ *
+ * Returns: Nothing.
+ */
+static void run_list_queue(int n, double *t_fill, double *t_steady)
+{
+	list *l = list_empty(NULL);
+	double t0 = now();
+	for (int i = 0; i < n; i++) {
+		list_insert(l, &l, list_end(l));
+	}
+	while (!list_is_empty(l)) {
+		list_inspect(l, list_first(l));
+		list_remove(l, list_first(l));
+	}
+	*t_fill = now() - t0;
+
+	for (int i = 0; i < 64; i++) {
+		list_insert(l, &l, list_end(l));
+	}
+	t0 = now();
+	for (int i = 0; i < n; i++) {
+		list_insert(l, &l, list_end(l));
+		list_inspect(l, list_first(l));
+		list_remove(l, list_first(l));
+	}
+	*t_steady = now() - t0;
+	list_kill(l);
+}
+
+/**
+ * bench_queue() - Compare enqueue/dequeue throughput of the ring buffer
+ *		   queue with a list-backed queue.
+ * @n: Number of elements to enqueue in each run.
+ *
+ * Returns: Nothing.
+ */
+static void bench_queue(int n)
+{
+	double ring_fill, ring_steady, list_fill, list_steady;
+	run_list_queue(n, &list_fill, &list_steady);
+	run_queue(n, &ring_fill, &ring_steady);
+
+	// one operation is one enqueue plus one dequeue
+	printf("queue fill ops=%d list=%.1fMops/s ring=%.1fMops/s\n", n,
+	       n / list_fill / 1e6, n / ring_fill / 1e6);
+	printf("queue steady ops=%d list=%.1fMops/s ring=%.1fMops/s\n", n,
+	       n / list_steady / 1e6, n / ring_steady / 1e6);
+}
+
+/**
+ * random_graph() - Build a graph with uniformly random edges.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @seed: Seed for the random generator, non-zero.
+ *
+ * Returns: The new graph.
+ */
+static graph *random_graph(int num_nodes, int num_edges, unsigned int seed)
+{
+	char **names = make_names(num_nodes);
+	graph *g = graph_empty(num_nodes);
+	node **nodes = malloc(num_nodes * sizeof(*nodes));
+
+	for (int i = 0; i < num_nodes; i++) {
+		graph_insert_node(g, names[i]);
+		nodes[i] = graph_find_node(g, names[i]);
+	}
+	for (int i = 0; i < num_edges; i++) {
+		int u = rnd(&seed) % num_nodes;
+		int v = rnd(&seed) % num_nodes;
+		graph_insert_edge(g, nodes[u], nodes[v]);
+	}
+
+	free(nodes);
+	free_names(names, num_nodes);
+	return g;
+}
+
+/**
+ * bench_search() - Compare the point-to-point searches on random queries.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_queries: Number of random origin/destination pairs.
+ *
+ * Returns: Nothing.
+ */
+static void bench_search(int num_nodes, int num_edges, int num_queries)
+{
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int *pairs = malloc(2 * num_queries * sizeof(*pairs));
+	bool *answers = malloc(num_queries * sizeof(*answers));
+	for (int i = 0; i < 2 * num_queries; i++) {
+		pairs[i] = rnd(&state) % num_nodes;
+	}
+
+	// both csr engines reuse one scratch, as is_connected does
+	csr_scratch *scratch = csr_scratch_empty(c);
+	query_counters counters = {0};
+	int found = 0;
+	double t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		answers[i] = csr_find_path(c, pairs[2 * i], pairs[2 * i + 1],
+					   scratch, &counters);
+		found += answers[i];
+	}
+	printf("search engine=csr queries=%d found=%d time=%.4fs "
+	       "edges/query=%.0f\n", num_queries, found, now() - t0,
+	       (double)counters.scanned / num_queries);
+
+	query_counters zero = {0};
+	counters = zero;
+	t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		bool a = csr_find_path_bidir(c, pairs[2 * i],
+					     pairs[2 * i + 1], scratch,
+					     &counters);
+		if (a != answers[i]) {
+			printf("search engine=bidir MISMATCH query=%d\n", i);
+		}
+	}
+	printf("search engine=bidir queries=%d found=%d time=%.4fs "
+	       "edges/query=%.0f\n", num_queries, found, now() - t0,
+	       (double)counters.scanned / num_queries);
+	csr_scratch_kill(scratch);
+
+	// the path finder also returns the route, from arrays made once
+	path_finder *p = path_finder_empty(c);
+	int *route = malloc((num_nodes + 1) * sizeof(*route));
+	long hops = 0;
+	counters = zero;
+	t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		int length = path_finder_find(p, pairs[2 * i],
+					      pairs[2 * i + 1], route,
+					      &counters);
+		if ((length > 0) != answers[i]) {
+			printf("search engine=path MISMATCH query=%d\n", i);
+		}
+		hops += length > 0 ? length - 1 : 0;
+	}
+	printf("search engine=path queries=%d found=%d time=%.4fs "
+	       "edges/query=%.0f hops/path=%.2f\n", num_queries, found,
+	       now() - t0, (double)counters.scanned / num_queries,
+	       found > 0 ? (double)hops / found : 0.0);
+	path_finder_kill(p);
+	free(route);
+
+	long scanned = 0;
+	t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		bool a = bfs_dirop_find_path(c, pairs[2 * i],
+					     pairs[2 * i + 1], &scanned);
+		if (a != answers[i]) {
+			printf("search engine=dirop MISMATCH query=%d\n", i);
+		}
+	}
+	printf("search engine=dirop queries=%d found=%d time=%.4fs "
+	       "edges/query=%.0f\n", num_queries, found, now() - t0,
+	       (double)scanned / num_queries);
+
+	free(pairs);
+	free(answers);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_reach() - Compare full reachability searches from random sources.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_sources: Number of random sources.
+ *
+ * Returns: Nothing.
+ */
+static void bench_reach(int num_nodes, int num_edges, int num_sources)
+{
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int words = BITSET_WORDS(num_nodes);
+	bool *visited = malloc(num_nodes * sizeof(*visited));
+	uint64_t *visited_set = malloc(words * sizeof(*visited_set));
+	int *sources = malloc(num_sources * sizeof(*sources));
+	int *counts = malloc(num_sources * sizeof(*counts));
+	for (int i = 0; i < num_sources; i++) {
+		sources[i] = rnd(&state) % num_nodes;
+	}
+
+	double t0 = now();
+	for (int i = 0; i < num_sources; i++) {
+		memset(visited, 0, num_nodes * sizeof(*visited));
+		counts[i] = csr_reach(c, sources[i], visited);
+	}
+	printf("reach engine=csr sources=%d time=%.4fs\n", num_sources,
+	       now() - t0);
+
+	long scanned = 0;
+	t0 = now();
+	for (int i = 0; i < num_sources; i++) {
+		memset(visited_set, 0, words * sizeof(*visited_set));
+		int n = bfs_dirop_reach(c, sources[i], visited_set, &scanned);
+		if (n != counts[i]) {
+			printf("reach engine=dirop MISMATCH source=%d\n", i);
+		}
+	}
+	printf("reach engine=dirop sources=%d time=%.4fs edges/source=%.0f "
+	       "(of %d)\n", num_sources, now() - t0,
+	       (double)scanned / num_sources, num_edges);
+
+	free(visited);
+	free(visited_set);
+	free(sources);
+	free(counts);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_threads() - Measure how the parallel BFS scales with the number
+ *		     of threads.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_sources: Number of random sources.
+ *
+ * Runs full reachability searches from the same sources with 1, 2, 4,
+ * ... MAX_THREADS threads and checks the results against csr_reach().
+ *
+ * Returns: Nothing.
+ */
+static void bench_threads(int num_nodes, int num_edges, int num_sources)
+{
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int words = BITSET_WORDS(num_nodes);
+	bool *visited = malloc(num_nodes * sizeof(*visited));
+	uint64_t *visited_set = malloc(words * sizeof(*visited_set));
+	int *sources = malloc(num_sources * sizeof(*sources));
+	int *counts = malloc(num_sources * sizeof(*counts));
+	for (int i = 0; i < num_sources; i++) {
+		sources[i] = rnd(&state) % num_nodes;
+		memset(visited, 0, num_nodes * sizeof(*visited));
+		counts[i] = csr_reach(c, sources[i], visited);
+	}
+
+	double t1 = 0;
+	for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+		double t0 = now();
+		for (int i = 0; i < num_sources; i++) {
+			memset(visited_set, 0, words * sizeof(*visited_set));
+			int n = bfs_parallel_reach(c, sources[i], visited_set,
+						   threads, NULL);
+			if (n != counts[i]) {
+				printf("threads MISMATCH source=%d\n", i);
+			}
+		}
+		double t = now() - t0;
+		if (threads == 1) {
+			t1 = t;
+		}
+		printf("threads threads=%d sources=%d time=%.4fs "
+		       "speedup=%.2f\n", threads, num_sources, t, t1 / t);
+	}
+
+	free(visited);
+	free(visited_set);
+	free(sources);
+	free(counts);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_multi() - Compare one multi-source BFS with separate searches.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_sources: Number of random sources, at most BFS_MULTI_MAX.
+ *
+ * Returns: Nothing.
+ */
+static void bench_multi(int num_nodes, int num_edges, int num_sources)
+{
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int words = BITSET_WORDS(num_nodes);
+	uint64_t *visited_set = malloc(words * sizeof(*visited_set));
+	uint64_t *reach = malloc(num_nodes * sizeof(*reach));
+	int sources[BFS_MULTI_MAX];
+	if (num_sources > BFS_MULTI_MAX) {
+		num_sources = BFS_MULTI_MAX;
+	}
+	for (int i = 0; i < num_sources; i++) {
+		sources[i] = rnd(&state) % num_nodes;
+	}
+
+	long total = 0;
+	double t0 = now();
+	for (int i = 0; i < num_sources; i++) {
+		memset(visited_set, 0, words * sizeof(*visited_set));
+		total += bfs_dirop_reach(c, sources[i], visited_set, NULL);
+	}
+	printf("multi engine=dirop sources=%d pairs=%ld time=%.4fs\n",
+	       num_sources, total, now() - t0);
+
+	t0 = now();
+	long pairs = bfs_multi_reach(c, sources, num_sources, reach);
+	printf("multi engine=msbfs sources=%d pairs=%ld time=%.4fs%s\n",
+	       num_sources, pairs, now() - t0,
+	       pairs == total ? "" : " MISMATCH");
+
+	free(visited_set);
+	free(reach);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_index() - Measure build and query time of the reachability index.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_queries: Number of random origin/destination pairs.
+ *
+ * Returns: Nothing.
+ */
+static void bench_index(int num_nodes, int num_edges, int num_queries)
+{
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int *pairs = malloc(2 * num_queries * sizeof(*pairs));
+	for (int i = 0; i < 2 * num_queries; i++) {
+		pairs[i] = rnd(&state) % num_nodes;
+	}
+
+	double t0 = now();
+	reach_index *idx = reach_index_build(c, 3);
+	double t_build = now() - t0;
+
+	int found = 0;
+	t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		found += reach_index_query(idx, pairs[2 * i],
+					   pairs[2 * i + 1]);
+	}
+	double t_query = now() - t0;
+
+	long by_labels, by_search;
+	reach_index_counts(idx, &by_labels, &by_search);
+	printf("index nodes=%d edges=%d components=%d build=%.4fs "
+	       "queries=%d found=%d query=%.3fus labels=%ld search=%ld\n",
+	       num_nodes, num_edges, reach_index_num_components(idx),
+	       t_build, num_queries, found, 1e6 * t_query / num_queries,
+	       by_labels, by_search);
+
+	for (int i = 0; i < num_queries && i < CHECKED_QUERIES; i++) {
+		int u = pairs[2 * i];
+		int v = pairs[2 * i + 1];
+		if (reach_index_query(idx, u, v)
+		    != csr_find_path(c, u, v, NULL, NULL)) {
+			printf("index MISMATCH query=%d\n", i);
+		}
+	}
+
+	free(pairs);
+	reach_index_kill(idx);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_hop() - Measure build, save, load and query time of the 2-hop
+ *		 labels, and report their size.
+ * @num_nodes: Number of nodes of the random graph.
+ * @num_edges: Number of edges of the random graph.
+ * @num_queries: Number of random queries to time.
+ *
+ * Returns: Nothing.
+ */
+static void bench_hop(int num_nodes, int num_edges, int num_queries)
+{
+	const char *path = "bench.hop";
+	unsigned int state = 4711;
+	graph *g = random_graph(num_nodes, num_edges, 12345);
+	csr_graph *c = graph_freeze(g);
+	int *pairs = malloc(2 * num_queries * sizeof(*pairs));
+	for (int i = 0; i < 2 * num_queries; i++) {
+		pairs[i] = rnd(&state) % num_nodes;
+	}
+
+	double t0 = now();
+	hop_index *idx = hop_index_build(c);
+	double t_build = now() - t0;
+
+	t0 = now();
+	hop_index_save(idx, c, path);
+	double t_save = now() - t0;
+	hop_index_kill(idx);
+	t0 = now();
+	idx = hop_index_load(c, path);
+	double t_load = now() - t0;
+	remove(path);
+	if (idx == NULL) {
+		printf("hop LOAD FAILED\n");
+		idx = hop_index_build(c);
+	}
+
+	int found = 0;
+	t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		found += hop_index_query(idx, pairs[2 * i], pairs[2 * i + 1]);
+	}
+	double t_query = now() - t0;
+
+	hop_stats stats;
+	hop_index_stats(idx, &stats);
+	printf("hop nodes=%d edges=%d build=%.4fs save=%.4fs load=%.4fs "
+	       "queries=%d found=%d query=%.3fus out=%ld in=%ld "
+	       "mean_out=%.2f mean_in=%.2f max_out=%d max_in=%d bytes=%zu\n",
+	       num_nodes, num_edges, t_build, t_save, t_load, num_queries,
+	       found, 1e6 * t_query / num_queries, stats.out_entries,
+	       stats.in_entries, (double)stats.out_entries / num_nodes,
+	       (double)stats.in_entries / num_nodes, stats.max_out,
+	       stats.max_in, stats.bytes);
+
+	for (int i = 0; i < num_queries && i < CHECKED_QUERIES; i++) {
+		int u = pairs[2 * i];
+		int v = pairs[2 * i + 1];
+		if (hop_index_query(idx, u, v)
+		    != csr_find_path(c, u, v, NULL, NULL)) {
+			printf("hop MISMATCH query=%d\n", i);
+		}
+	}
+
+	free(pairs);
+	hop_index_kill(idx);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * bench_route() - Measure Dijkstra queries on random edge weights.
+ * @num_nodes: Number of nodes of the random graph.
+ * @num_edges: Number of edges of the random graph.
+ * @num_queries: Number of random queries to time.
+ *
+ * Returns: Nothing.
+ */
+static void bench_route(int num_nodes, int num_edges, int num_queries)
+{
+	unsigned int seed = 12345;
+	unsigned int state = 4711;
+	char **names = make_names(num_nodes);
+	graph *g = graph_empty(num_nodes);
+	node **nodes = malloc(num_nodes * sizeof(*nodes));
+	for (int i = 0; i < num_nodes; i++) {
+		graph_insert_node(g, names[i]);
+		nodes[i] = graph_find_node(g, names[i]);
+	}
+	for (int i = 0; i < num_edges; i++) {
+		int u = rnd(&seed) % num_nodes;
+		int v = rnd(&seed) % num_nodes;
+		graph_insert_weighted_edge(g, nodes[u], nodes[v],
+					   1 + rnd(&seed) % MAX_WEIGHT);
+	}
+	csr_graph *c = graph_freeze(g);
+	int *pairs = malloc(2 * num_queries * sizeof(*pairs));
+	for (int i = 0; i < 2 * num_queries; i++) {
+		pairs[i] = rnd(&state) % num_nodes;
+	}
+
+	dijkstra *d = dijkstra_empty(c);
+	query_counters counters = {0};
+	int found = 0;
+	long cost = 0;
+	double t0 = now();
+	for (int i = 0; i < num_queries; i++) {
+		long dist = dijkstra_distance(d, pairs[2 * i],
+					      pairs[2 * i + 1], &counters);
+		if (dist >= 0) {
+			found++;
+			cost += dist;
+		}
+	}
+	double t_query = now() - t0;
+	printf("route nodes=%d edges=%d queries=%d found=%d time=%.4fs "
+	       "query=%.3fus mean_cost=%.1f dequeued/query=%.0f "
+	       "edges/query=%.0f peak_heap=%ld\n", num_nodes, num_edges,
+	       num_queries, found, t_query, 1e6 * t_query / num_queries,
+	       found > 0 ? (double)cost / found : 0.0,
+	       (double)counters.dequeued / num_queries,
+	       (double)counters.scanned / num_queries, counters.peak_queue);
+
+	for (int i = 0; i < num_queries && i < CHECKED_QUERIES; i++) {
+		int u = pairs[2 * i];
+		int v = pairs[2 * i + 1];
+		if ((dijkstra_distance(d, u, v, NULL) >= 0)
+		    != csr_find_path(c, u, v, NULL, NULL)) {
+			printf("route MISMATCH query=%d\n", i);
+		}
+	}
+
+	dijkstra_kill(d);
+	free(pairs);
+	free(nodes);
+	free_names(names, num_nodes);
+	csr_kill(c);
+	graph_kill(g);
+}
+
+/**
+ * same_snapshot() - See if two snapshots hold the same graph.
+ * @a: First snapshot.
+ * @b: Second snapshot.
+ *
+ * Returns: True if the node ids, the edges in order and their weights
+ * are the same, in both directions.
+ */
+static bool same_snapshot(const csr_graph *a, const csr_graph *b)
+{
+	return a->num_nodes == b->num_nodes && a->num_edges == b->num_edges
+		&& memcmp(a->offsets, b->offsets,
+			  (a->num_nodes + 1) * sizeof(*a->offsets)) == 0
+		&& memcmp(a->targets, b->targets,
+			  a->num_edges * sizeof(*a->targets)) == 0
+		&& memcmp(a->weights, b->weights,
+			  a->num_edges * sizeof(*a->weights)) == 0
+		&& memcmp(a->in_offsets, b->in_offsets,
+			  (a->num_nodes + 1) * sizeof(*a->in_offsets)) == 0
+		&& memcmp(a->sources, b->sources,
+			  a->num_edges * sizeof(*a->sources)) == 0;
+}
+
+/**
+ * bench_map() - Measure loading of map files of random edges.
+ * @num_nodes: Number of distinct node names.
+ * @num_edges: Number of edges of the largest file.
+ *
+ * Loads files of a quarter, half and all of the edges with 1, 2, 4,
+ * ... MAX_THREADS threads, and checks that every load gives the same
+ * graph as the load without threads.
+ *
+ * Returns: Nothing.
+ */
+static void bench_map(int num_nodes, int num_edges)
+{
+	const char *path = "bench.map";
+	char **names = make_names(num_nodes);
+
+	for (int part = 4; part >= 1; part /= 2) {
+		unsigned int state = 12345;
+		int edges = num_edges / part;
+		FILE *f = fopen(path, "w");
+		if (f == NULL) {
+			printf("map CANNOT WRITE %s\n", path);
+			break;
+		}
+		fprintf(f, "# random map\n%d\n", edges);
+		for (int i = 0; i < edges; i++) {
+			int u = rnd(&state) % num_nodes;
+			int v = rnd(&state) % num_nodes;
+			fprintf(f, "%s %s\n", names[u], names[v]);
+		}
+		long size = ftell(f);
+		fclose(f);
+
+		csr_graph *serial = NULL;
+		double t1 = 0;
+		for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+			map_stats stats;
+			double t0 = now();
+			graph *g = map_load(path, false, threads, &stats);
+			double t_load = now() - t0;
+			csr_graph *c = graph_freeze(g);
+			bool same = true;
+			if (threads == 1) {
+				serial = c;
+				t1 = t_load;
+			} else {
+				same = same_snapshot(serial, c);
+				csr_kill(c);
+			}
+			printf("map nodes=%d edges=%d size=%.1fMB threads=%d "
+			       "load=%.4fs rate=%.1fMB/s edges/s=%.0f "
+			       "speedup=%.2f%s%s\n", num_nodes, edges,
+			       size / 1e6, threads, t_load,
+			       size / 1e6 / t_load, edges / t_load,
+			       t1 / t_load,
+			       stats.edges == edges ? ""
+			       : " EDGE COUNT MISMATCH",
+			       same ? "" : " GRAPH MISMATCH");
+			graph_kill(g);
+		}
+		csr_kill(serial);
+	}
+
+	remove(path);
+	free_names(names, num_nodes);
+}
+
+/**
+ * bench_snap() - Compare loading a map file with loading its snapshot.
+ * @num_nodes: Number of distinct node names.
+ * @num_edges: Number of edges of the file.
+ *
+ * Returns: Nothing.
+ */
+static void bench_snap(int num_nodes, int num_edges)
+{
+	const char *map_path = "bench.map";
+	const char *snap_path = "bench.snap";
+	unsigned int state = 12345;
+	char **names = make_names(num_nodes);
+	FILE *f = fopen(map_path, "w");
+	if (f == NULL) {
+		printf("snap CANNOT WRITE %s\n", map_path);
+		free_names(names, num_nodes);
+		return;
+	}
+	fprintf(f, "# random map\n%d\n", num_edges);
+	for (int i = 0; i < num_edges; i++) {
+		int u = rnd(&state) % num_nodes;
+		int v = rnd(&state) % num_nodes;
+		fprintf(f, "%s %s\n", names[u], names[v]);
+	}
+	fclose(f);
+
+	map_stats stats;
+	double t0 = now();
+	graph *g = map_load(map_path, false, 1, &stats);
+	double t_map = now() - t0;
+	t0 = now();
+	bool saved = graph_save_binary(g, snap_path);
+	double t_save = now() - t0;
+	t0 = now();
+	graph *h = graph_load_binary(snap_path, false, NULL);
+	double t_snap = now() - t0;
+	// the frozen modes of is_connected load the snapshot without edges
+	csr_graph *frozen = NULL;
+	t0 = now();
+	graph *k = graph_load_binary(snap_path, false, &frozen);
+	double t_frozen = now() - t0;
+
+	bool same = false;
+	if (saved && h != NULL && k != NULL) {
+		csr_graph *a = graph_freeze(g);
+		csr_graph *b = graph_freeze(h);
+		same = same_snapshot(a, b) && same_snapshot(a, frozen);
+		csr_kill(a);
+		csr_kill(b);
+	}
+	if (h != NULL) {
+		graph_kill(h);
+	}
+	if (k != NULL) {
+		csr_kill(frozen);
+		graph_kill(k);
+	}
+	printf("snap nodes=%d edges=%d map=%.4fs save=%.4fs snap=%.4fs "
+	       "frozen=%.4fs speedup=%.2f%s\n", num_nodes, num_edges, t_map,
+	       t_save, t_snap, t_frozen, t_map / t_snap,
+	       same ? "" : " GRAPH MISMATCH");
+
+	remove(map_path);
+	remove(snap_path);
+	graph_kill(g);
+	free_names(names, num_nodes);
+}
+
+/**
+ * gen_rmat() - Generate a power-law graph with the R-MAT model.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @count: Set to the number of edges generated, num_edges.
+ *
+ * Each edge picks a quadrant of the adjacency matrix with probabilities
+ * 0.57, 0.19, 0.19, 0.05 once per bit of the node indices, which gives
+ * the skewed degrees of real networks.
+ *
+ * Returns: The edges, 2*count node indices.
+ */
+static int *gen_rmat(int num_nodes, int num_edges, int *count)
+{
+	unsigned int state = 12345;
+	int *edges = malloc(2 * (num_edges + 1) * sizeof(*edges));
+	int bits = 0;
+	while ((1 << bits) < num_nodes) {
+		bits++;
+	}
+	for (int i = 0; i < num_edges; i++) {
+		int u, v;
+		do {
+			u = 0;
+			v = 0;
+			for (int b = 0; b < bits; b++) {
+				double r = (rnd(&state) & 0xffffff) / 16777216.0;
+				u = 2 * u + (r >= 0.76);
+				v = 2 * v + ((r >= 0.57 && r < 0.76) || r >= 0.95);
+			}
+		} while (u >= num_nodes || v >= num_nodes);
+		edges[2 * i] = u;
+		edges[2 * i + 1] = v;
+	}
+	*count = num_edges;
+	return edges;
+}
+
+/**
+ * gen_grid() - Generate a square grid of two-way edges.
+ * @num_nodes: Number of nodes, rounded down to a square.
+ * @num_edges: Not used, a grid has 4*side*(side-1) edges.
+ * @count: Set to the number of edges generated.
+ *
+ * Returns: The edges, 2*count node indices.
+ */
+static int *gen_grid(int num_nodes, int num_edges, int *count)
+{
+	(void)num_edges;
+	int side = 1;
+	while ((side + 1) * (side + 1) <= num_nodes) {
+		side++;
+	}
+	int *edges = malloc(2 * (4 * side * (side - 1) + 1) * sizeof(*edges));
+	int k = 0;
+	for (int r = 0; r < side; r++) {
+		for (int c = 0; c < side; c++) {
+			int u = r * side + c;
+			if (c + 1 < side) {
+				edges[k++] = u;
+				edges[k++] = u + 1;
+				edges[k++] = u + 1;
+				edges[k++] = u;
+			}
+			if (r + 1 < side) {
+				edges[k++] = u;
+				edges[k++] = u + side;
+				edges[k++] = u + side;
+				edges[k++] = u;
+			}
+		}
+	}
+	*count = k / 2;
+	return edges;
+}
+
+/**
+ * gen_hub() - Generate a hub-and-spoke airline network.
+ * @num_nodes: Number of nodes, one in a hundred is a hub.
+ * @num_edges: Number of edges, at least two per spoke are generated.
+ * @count: Set to the number of edges generated.
+ *
+ * Every spoke has a route to and from a random hub, the remaining edges
+ * are random routes between hubs.
+ *
+ * Returns: The edges, 2*count node indices.
+ */
+static int *gen_hub(int num_nodes, int num_edges, int *count)
+{
+	unsigned int state = 12345;
+	int num_hubs = num_nodes / 100 + 1;
+	int num_spokes = num_nodes > num_hubs ? num_nodes - num_hubs : 0;
+	int total = 2 * num_spokes;
+	if (num_edges > total) {
+		total = num_edges;
+	}
+	int *edges = malloc(2 * (total + 1) * sizeof(*edges));
+	int k = 0;
+	for (int s = num_hubs; s < num_nodes; s++) {
+		int h = rnd(&state) % num_hubs;
+		edges[k++] = s;
+		edges[k++] = h;
+		edges[k++] = h;
+		edges[k++] = s;
+	}
+	while (k < 2 * total) {
+		edges[k++] = rnd(&state) % num_hubs;
+		edges[k++] = rnd(&state) % num_hubs;
+	}
+	*count = total;
+	return edges;
+}
+
+// Generators selectable by name.
+static const struct generator generators[] = {
+	{"rmat", gen_rmat},
+	{"grid", gen_grid},
+	{"hub", gen_hub},
+};
+
+#define NUM_GENERATORS (int)(sizeof(generators) / sizeof(generators[0]))
+
+/**
+ * find_generator() - Look up a generator by name.
+ * @name: Name of the generator.
+ *
+ * Returns: The generator, or NULL if there is none with the name.
+ */
+static const struct generator *find_generator(const char *name)
+{
+	for (int i = 0; i < NUM_GENERATORS; i++) {
+		if (strcmp(generators[i].name, name) == 0) {
+			return &generators[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * write_map() - Write generated edges as a map file.
+ * @path: Name of the file.
+ * @edges: Edges, 2*count node indices. Node i is named N<i>.
+ * @count: Number of edges.
+ *
+ * Returns: The size of the file in bytes, or -1 if it could not be
+ * written.
+ */
+static long write_map(const char *path, const int *edges, int count)
+{
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		return -1;
+	}
+	fprintf(f, "# generated map\n%d\n", count);
+	for (int i = 0; i < count; i++) {
+		fprintf(f, "N%d N%d\n", edges[2 * i], edges[2 * i + 1]);
+	}
+	long size = ftell(f);
+	if (fclose(f) != 0) {
+		return -1;
+	}
+	return size;
+}
+
+/**
+ * walk_path() - See if a path exists between two nodes, following the
+ *		 edges of the graph the way is_connected's find_path() does.
+ * @g: Graph to inspect.
+ * @src: Source node.
+ * @dest: Destination node.
+ *
+ * find_path() is defined next to main() in is_connected.c and can not be
+ * linked in here, so this is a copy of it and is reported as
+ * find_path_copy. Changes to find_path() must be made here as well.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+static bool walk_path(graph *g, node *src, node *dest)
+{
+	queue *q = queue_empty(NULL);
+	bool found = false;
+	queue_enqueue(q, src);
+	graph_node_set_seen(g, src, true);
+	while (!found && !queue_is_empty(q)) {
+		node *n = queue_front(q);
+		queue_dequeue(q);
+		for (edge *e = graph_first_edge(g, n); e != NULL;
+		     e = graph_next_edge(g, e)) {
+			node *t = graph_edge_target(g, e);
+			if (t == dest) {
+				found = true;
+				break;
+			}
+			if (!graph_node_is_seen(g, t)) {
+				queue_enqueue(q, t);
+				graph_node_set_seen(g, t, true);
+			}
+		}
+	}
+	queue_kill(q);
+	graph_reset_seen(g);
+	return found;
+}
+
+/**
+ * walk_path_ids() - See if a path exists between two nodes, keeping the
+ *		     state of the search in arrays indexed by node id.
+ * @g: Graph to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @queue: Queue of graph_node_count() ids.
+ * @seen: Stamp of each of the graph_node_count() ids.
+ * @stamp: Stamp of this search, different from all earlier ones.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+static bool walk_path_ids(const graph *g, int src, int dest, int *queue,
+			  int *seen, int stamp)
+{
+	int head = 0;
+	int tail = 0;
+	queue[tail++] = src;
+	seen[src] = stamp;
+	while (head < tail) {
+		int u = queue[head++];
+		for (edge *e = graph_first_edge_by_id(g, u); e != NULL;
+		     e = graph_next_edge(g, e)) {
+			int v = graph_edge_target_id(g, e);
+			if (v == dest) {
+				return true;
+			}
+			if (seen[v] != stamp) {
+				seen[v] = stamp;
+				queue[tail++] = v;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * compare_times() - Order two time measurements for qsort().
+ * @a: Pointer to the first time.
+ * @b: Pointer to the second time.
+ *
+ * Returns: Negative, zero or positive as a is less, equal or greater.
+ */
+static int compare_times(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * report_times() - Print the throughput and latency percentiles of an
+ *		    operation on one key=value line.
+ * @kind: Name of the generated graph.
+ * @op: Name of the operation.
+ * @times: Time in seconds of each call, sorted by the function.
+ * @count: Number of calls, at least 1.
+ *
+ * Returns: Nothing.
+ */
+static void report_times(const char *kind, const char *op, double *times,
+			 int count)
+{
+	double total = 0;
+	for (int i = 0; i < count; i++) {
+		total += times[i];
+	}
+	qsort(times, count, sizeof(*times), compare_times);
+	printf("suite graph=%s op=%s ops=%d time=%.4fs ops/s=%.0f "
+	       "p50=%.3fus p90=%.3fus p99=%.3fus max=%.3fus\n", kind, op,
+	       count, total, count / total, 1e6 * times[count / 2],
+	       1e6 * times[count * 9 / 10], 1e6 * times[count * 99 / 100],
+	       1e6 * times[count - 1]);
+}
+
+/**
+ * bench_gen() - Write a generated graph as a map file.
+ * @kind: Name of the generator.
+ * @path: Name of the map file.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ *
+ * Returns: EXIT_SUCCESS, or EXIT_FAILURE if the file was not written.
+ */
+static int bench_gen(const char *kind, const char *path, int num_nodes,
+		     int num_edges)
+{
+	const struct generator *gen = find_generator(kind);
+	if (gen == NULL) {
+		fprintf(stderr, "Unknown generator %s\n", kind);
+		return EXIT_FAILURE;
+	}
+	int count;
+	int *edges = gen->make(num_nodes, num_edges, &count);
+	long size = write_map(path, edges, count);
+	free(edges);
+	if (size < 0) {
+		fprintf(stderr, "File can not be written\n");
+		return EXIT_FAILURE;
+	}
+	printf("gen graph=%s nodes=%d edges=%d size=%.1fMB\n", kind,
+	       num_nodes, count, size / 1e6);
+	return EXIT_SUCCESS;
+}
+
+/**
+ * shuffled_graph() - Build a graph from generated edges with its nodes
+ *		      inserted in random order.
+ * @gen: Generator of the edges.
+ * @names: Name of each node index of the generator.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges to ask the generator for.
+ *
+ * A map lists its nodes in no particular order, so the ids of the
+ * neighbours of a node are scattered as well.
+ *
+ * Returns: The new graph.
+ */
+static graph *shuffled_graph(const struct generator *gen, char **names,
+			     int num_nodes, int num_edges)
+{
+	unsigned int state = 99;
+	int *perm = malloc(num_nodes * sizeof(*perm));
+	for (int i = 0; i < num_nodes; i++) {
+		perm[i] = i;
+	}
+	for (int i = num_nodes - 1; i > 0; i--) {
+		int j = rnd(&state) % (i + 1);
+		int t = perm[i];
+		perm[i] = perm[j];
+		perm[j] = t;
+	}
+	graph *g = graph_empty(num_nodes);
+	for (int i = 0; i < num_nodes; i++) {
+		graph_insert_node(g, names[perm[i]]);
+	}
+
+	int count;
+	int *edges = gen->make(num_nodes, num_edges, &count);
+	for (int i = 0; i < count; i++) {
+		graph_insert_edge(g, graph_find_node(g, names[edges[2 * i]]),
+				  graph_find_node(g, names[edges[2 * i + 1]]));
+	}
+	free(edges);
+	free(perm);
+	return g;
+}
+
+/**
+ * mean_gap() - Return the mean distance between the ids of the ends of
+ *		the edges of a snapshot.
+ * @c: Snapshot to inspect.
+ *
+ * Returns: The mean gap, 0 if there are no edges.
+ */
+static double mean_gap(const csr_graph *c)
+{
+	double sum = 0;
+	for (int u = 0; u < c->num_nodes; u++) {
+		for (int k = c->offsets[u]; k < c->offsets[u + 1]; k++) {
+			sum += abs(c->targets[k] - u);
+		}
+	}
+	return c->num_edges > 0 ? sum / c->num_edges : 0;
+}
+
+/**
+ * bench_reorder() - Compare BFS time before and after each node order.
+ * @kind: Name of the generator.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges to ask the generator for.
+ * @num_sources: Number of random sources of full BFS:s.
+ *
+ * Returns: Nothing.
+ */
+static void bench_reorder(const char *kind, int num_nodes, int num_edges,
+			  int num_sources)
+{
+	static const char *orders[] = {"none", "bfs", "rcm", "degree"};
+	const struct generator *gen = find_generator(kind);
+	char **names = make_names(num_nodes);
+	bool *visited = malloc(num_nodes * sizeof(*visited));
+	int *sources = malloc(num_sources * sizeof(*sources));
+	unsigned int state = 4711;
+	for (int i = 0; i < num_sources; i++) {
+		sources[i] = rnd(&state) % num_nodes;
+	}
+
+	double t_none = 0;
+	long reached_none = 0;
+	for (int o = 0; o < 4; o++) {
+		graph *g = shuffled_graph(gen, names, num_nodes, num_edges);
+		double t0 = now();
+		if (o > 0) {
+			graph_reorder(g, GRAPH_ORDER_BFS + o - 1);
+		}
+		double t_reorder = now() - t0;
+		csr_graph *c = graph_freeze(g);
+
+		long reached = 0;
+		t0 = now();
+		for (int i = 0; i < num_sources; i++) {
+			node *n = graph_find_node(g, names[sources[i]]);
+			memset(visited, 0, num_nodes * sizeof(*visited));
+			reached += csr_reach(c, graph_node_id(g, n), visited);
+		}
+		double t_bfs = now() - t0;
+		if (o == 0) {
+			t_none = t_bfs;
+			reached_none = reached;
+		}
+		printf("reorder graph=%s order=%s nodes=%d edges=%d "
+		       "reorder=%.4fs gap=%.0f bfs=%.4fs speedup=%.2f%s\n",
+		       kind, orders[o], c->num_nodes, c->num_edges, t_reorder,
+		       mean_gap(c), t_bfs, t_none / t_bfs,
+		       reached == reached_none ? "" : " MISMATCH");
+
+		csr_kill(c);
+		graph_kill(g);
+	}
+
+	free(visited);
+	free(sources);
+	free_names(names, num_nodes);
+}
+
+/**
+ * bench_suite() - Time the graph operations on a generated map.
+ * @kind: Name of the generator.
+ * @num_nodes: Number of nodes.
+ * @num_edges: Number of edges.
+ * @num_queries: Number of lookups and of insertions.
+ *
+ * Loads the map, then times graph_find_node() on random names,
+ * graph_insert_edge() between random nodes, SUITE_PATHS find_path()
+ * searches and graph_kill(). Every call is timed on its own, so the
+ * percentiles include the cost of reading the clock.
+ *
+ * Returns: Nothing.
+ */
+static void bench_suite(const char *kind, int num_nodes, int num_edges,
+			int num_queries)
+{
+	const struct generator *gen = find_generator(kind);
+	const char *path = "bench.map";
+	int count;
+	int *edges = gen->make(num_nodes, num_edges, &count);
+	long size = write_map(path, edges, count);
+	free(edges);
+	if (size < 0) {
+		printf("suite CANNOT WRITE %s\n", path);
+		return;
+	}
+
+	map_stats stats;
+	double t0 = now();
+	graph *g = map_load(path, false, 1, &stats);
+	double t_build = now() - t0;
+	remove(path);
+	printf("suite graph=%s op=build nodes=%d edges=%d size=%.1fMB "
+	       "time=%.4fs edges/s=%.0f%s\n", kind, num_nodes, count,
+	       size / 1e6, t_build, count / t_build,
+	       stats.edges == count ? "" : " EDGE COUNT MISMATCH");
+
+	unsigned int state = 4711;
+	char **names = make_names(num_nodes);
+	double *times = malloc((num_queries + 1) * sizeof(*times));
+	node **found = malloc((num_queries + 1) * sizeof(*found));
+	int num_found = 0;
+	for (int i = 0; i < num_queries; i++) {
+		const char *name = names[rnd(&state) % num_nodes];
+		t0 = now();
+		node *n = graph_find_node(g, name);
+		times[i] = now() - t0;
+		if (n != NULL) {
+			found[num_found++] = n;
+		}
+	}
+	report_times(kind, "find_node", times, num_queries);
+
+	if (num_found > 0) {
+		for (int i = 0; i < num_queries; i++) {
+			node *n1 = found[rnd(&state) % num_found];
+			node *n2 = found[rnd(&state) % num_found];
+			t0 = now();
+			graph_insert_edge(g, n1, n2);
+			times[i] = now() - t0;
+		}
+		report_times(kind, "insert_edge", times, num_queries);
+
+		int num_paths = SUITE_PATHS;
+		int reached = 0;
+		node **ends = malloc(2 * num_paths * sizeof(*ends));
+		for (int i = 0; i < 2 * num_paths; i++) {
+			ends[i] = found[rnd(&state) % num_found];
+		}
+		for (int i = 0; i < num_paths; i++) {
+			t0 = now();
+			reached += walk_path(g, ends[2 * i], ends[2 * i + 1]);
+			times[i] = now() - t0;
+		}
+		report_times(kind, "find_path_copy", times, num_paths);
+		printf("suite graph=%s op=find_path_copy reached=%d\n", kind,
+		       reached);
+
+		// the same searches with their state in arrays sized once
+		int num_ids = graph_node_count(g);
+		int *queue = malloc((num_ids + 1) * sizeof(*queue));
+		int *seen = calloc(num_ids + 1, sizeof(*seen));
+		int reached_ids = 0;
+		for (int i = 0; i < num_paths; i++) {
+			int src = graph_node_id(g, ends[2 * i]);
+			int dest = graph_node_id(g, ends[2 * i + 1]);
+			t0 = now();
+			reached_ids += walk_path_ids(g, src, dest, queue, seen,
+						     i + 1);
+			times[i] = now() - t0;
+		}
+		report_times(kind, "find_path_copy_ids", times, num_paths);
+		if (reached_ids != reached) {
+			printf("suite graph=%s op=find_path_copy_ids MISMATCH\n",
+			       kind);
+		}
+		free(queue);
+		free(seen);
+		free(ends);
+	}
+
+	t0 = now();
+	graph_kill(g);
+	printf("suite graph=%s op=kill time=%.4fs\n", kind, now() - t0);
+
+	free(times);
+	free(found);
+	free_names(names, num_nodes);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc >= 2 && strcmp(argv[1], "load") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 10000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_load(num_nodes, num_edges);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "queue") == 0) {
+		bench_queue(argc > 2 ? atoi(argv[2]) : 10000000);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "search") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_search(num_nodes, num_edges,
+			     argc > 4 ? atoi(argv[4]) : 100);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "reach") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 16 * num_nodes;
+		bench_reach(num_nodes, num_edges,
+			    argc > 4 ? atoi(argv[4]) : 10);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "threads") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 16 * num_nodes;
+		bench_threads(num_nodes, num_edges,
+			      argc > 4 ? atoi(argv[4]) : 10);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "multi") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_multi(num_nodes, num_edges,
+			    argc > 4 ? atoi(argv[4]) : BFS_MULTI_MAX);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "index") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_index(num_nodes, num_edges,
+			    argc > 4 ? atoi(argv[4]) : 1000000);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "hop") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_hop(num_nodes, num_edges,
+			  argc > 4 ? atoi(argv[4]) : 1000000);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "route") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_route(num_nodes, num_edges,
+			    argc > 4 ? atoi(argv[4]) : 100);
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "map") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_map(num_nodes, num_edges);
+		return 0;
+	}
+	if (argc >= 2 && strcmp(argv[1], "snap") == 0) {
+		int num_nodes = argc > 2 ? atoi(argv[2]) : 1000000;
+		int num_edges = argc > 3 ? atoi(argv[3]) : 4 * num_nodes;
+		bench_snap(num_nodes, num_edges);
+		return 0;
+	}
+	if (argc >= 4 && strcmp(argv[1], "gen") == 0) {
+		int num_nodes = argc > 4 ? atoi(argv[4]) : 1000000;
+		int num_edges = argc > 5 ? atoi(argv[5]) : 4 * num_nodes;
+		return bench_gen(argv[2], argv[3], num_nodes, num_edges);
+	}
+	if (argc >= 2 && strcmp(argv[1], "suite") == 0
+	    && (argc == 2 || strcmp(argv[2], "all") == 0
+		|| find_generator(argv[2]) != NULL)) {
+		int num_nodes = argc > 3 ? atoi(argv[3]) : 1000000;
+		int num_edges = argc > 4 ? atoi(argv[4]) : 4 * num_nodes;
+		int num_queries = argc > 5 ? atoi(argv[5]) : 100000;
+		if (num_queries < 1) {
+			num_queries = 1;
+		}
+		// all generators unless one is named
+		for (int i = 0; i < NUM_GENERATORS; i++) {
+			if (argc > 2 && strcmp(argv[2], "all") != 0
+			    && strcmp(argv[2], generators[i].name) != 0) {
+				continue;
+			}
+			bench_suite(generators[i].name, num_nodes, num_edges,
+				    num_queries);
+		}
+		return 0;
+	}
+
+	if (argc >= 2 && strcmp(argv[1], "reorder") == 0
+	    && (argc == 2 || strcmp(argv[2], "all") == 0
+		|| find_generator(argv[2]) != NULL)) {
+		int num_nodes = argc > 3 ? atoi(argv[3]) : 1000000;
+		int num_edges = argc > 4 ? atoi(argv[4]) : 4 * num_nodes;
+		int num_sources = argc > 5 ? atoi(argv[5]) : 10;
+		for (int i = 0; i < NUM_GENERATORS; i++) {
+			if (argc > 2 && strcmp(argv[2], "all") != 0
+			    && strcmp(argv[2], generators[i].name) != 0) {
+				continue;
+			}
+			bench_reorder(generators[i].name, num_nodes, num_edges,
+				      num_sources);
+		}
+		return 0;
+	}
+
+	fprintf(stderr, "Usage: %s load [nodes] [edges]\n"
+		"       %s queue [operations]\n"
+		"       %s search [nodes] [edges] [queries]\n"
+		"       %s reach [nodes] [edges] [sources]\n"
+		"       %s threads [nodes] [edges] [sources]\n"
+		"       %s multi [nodes] [edges] [sources]\n"
+		"       %s index [nodes] [edges] [queries]\n"
+		"       %s hop [nodes] [edges] [queries]\n"
+		"       %s route [nodes] [edges] [queries]\n"
+		"       %s map [nodes] [edges]\n"
+		"       %s snap [nodes] [edges]\n"
+		"       %s gen rmat|grid|hub <file> [nodes] [edges]\n"
+		"       %s suite [all|rmat|grid|hub] [nodes] [edges] "
+		"[queries]\n"
+		"       %s reorder [all|rmat|grid|hub] [nodes] [edges] "
+		"[sources]\n",
+		argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
+		argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
+		argv[0], argv[0]);
+	return EXIT_FAILURE;
+}
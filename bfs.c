@@ -0,0 +1,506 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bfs.h"
+
+/*
+ * Implementation of breadth-first search engines for CSR snapshots.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * Switching thresholds of the direction-optimizing BFS, from Beamer et
+ * al., "Direction-Optimizing Breadth-First Search", SC 2012. Go
+ * bottom-up when the frontier has more than 1/ALPHA of the unexplored
+ * edges, and back top-down when the frontier holds fewer than 1/BETA
+ * of the nodes.
+ */
+#define ALPHA 14
+#define BETA 24
+
+// Number of nodes a thread of the parallel BFS collects before it
+// copies them to the shared next frontier.
+#define LOCAL_BUFFER 1024
+
+/*
+ * State shared by the threads of the parallel BFS. Thread 0 is the
+ * calling thread; it also swaps the frontiers between levels while the
+ * other threads wait at the barrier. start is held while the threads
+ * are created, and num_threads and the barrier are only set once it is
+ * known how many of them started.
+ */
+struct parallel_bfs {
+	const csr_graph *c;
+	int dest;
+	int num_threads;
+	uint64_t *visited;
+	int *frontier;
+	int n_frontier;
+	int *next;
+	int n_next;
+	int count;
+	long edges;
+	bool done;
+	pthread_barrier_t barrier;
+	pthread_mutex_t start;
+};
+
+// Per-thread argument of the parallel BFS.
+struct parallel_worker {
+	struct parallel_bfs *shared;
+	int thread;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * top_down() - Expand a BFS level along the out-edges of the frontier.
+ * @c: Snapshot to inspect.
+ * @frontier: Ids of the frontier nodes.
+ * @n_frontier: Number of frontier nodes.
+ * @next: Array that receives the ids of the next frontier.
+ * @visited: Visited set, updated.
+ * @edges: Number of edges looked at, updated.
+ *
+ * Returns: The number of nodes in the next frontier.
+ */
+static int top_down(const csr_graph *c, const int *frontier, int n_frontier,
+		    int *next, uint64_t *visited, long *edges)
+{
+	int n_next = 0;
+	for (int i = 0; i < n_frontier; i++) {
+		int u = frontier[i];
+		*edges += c->offsets[u + 1] - c->offsets[u];
+		for (int k = c->offsets[u]; k < c->offsets[u + 1]; k++) {
+			int v = c->targets[k];
+			if (!bitset_test(visited, v)) {
+				bitset_set(visited, v);
+				next[n_next++] = v;
+			}
+		}
+	}
+	return n_next;
+}
+
+/**
+ * bottom_up() - Expand a BFS level by letting every unvisited node look
+ *		 for a parent in the frontier.
+ * @c: Snapshot to inspect.
+ * @frontier: Bitset of the frontier nodes.
+ * @next: Array that receives the ids of the next frontier.
+ * @visited: Visited set, updated.
+ * @edges: Number of edges looked at, updated.
+ *
+ * Returns: The number of nodes in the next frontier.
+ */
+static int bottom_up(const csr_graph *c, const uint64_t *frontier, int *next,
+		     uint64_t *visited, long *edges)
+{
+	int n_next = 0;
+	for (int v = 0; v < c->num_nodes; v++) {
+		if (bitset_test(visited, v)) {
+			continue;
+		}
+		for (int k = c->in_offsets[v]; k < c->in_offsets[v + 1]; k++) {
+			(*edges)++;
+			if (bitset_test(frontier, c->sources[k])) {
+				// One parent is enough, skip the other in-edges.
+				bitset_set(visited, v);
+				next[n_next++] = v;
+				break;
+			}
+		}
+	}
+	return n_next;
+}
+
+/**
+ * dirop() - Direction-optimizing BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the node to stop at, or -1 to visit everything.
+ * @visited: Visited set, all zero on entry.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: The number of visited nodes, or -1 if dest was found.
+ */
+static int dirop(const csr_graph *c, int src, int dest, uint64_t *visited,
+		 long *scanned)
+{
+	int words = BITSET_WORDS(c->num_nodes);
+	// The source may appear twice, at level 0 and when it is reached.
+	int *frontier = malloc((c->num_nodes + 1) * sizeof(*frontier));
+	int *next = malloc((c->num_nodes + 1) * sizeof(*next));
+	uint64_t *frontier_set = malloc(words * sizeof(*frontier_set));
+	int n_frontier = 1;
+	int count = 0;
+	long edges = 0;
+	long unexplored = c->num_edges;
+	bool bottom = false;
+
+	frontier[0] = src;
+	while (n_frontier > 0) {
+		// Choose the direction from the edges around the frontier.
+		long frontier_edges = 0;
+		for (int i = 0; i < n_frontier; i++) {
+			int u = frontier[i];
+			frontier_edges += c->offsets[u + 1] - c->offsets[u];
+		}
+		if (!bottom && frontier_edges > unexplored / ALPHA) {
+			bottom = true;
+		} else if (bottom && n_frontier < c->num_nodes / BETA) {
+			bottom = false;
+		}
+		unexplored -= frontier_edges;
+
+		int n_next;
+		if (bottom) {
+			memset(frontier_set, 0, words * sizeof(*frontier_set));
+			for (int i = 0; i < n_frontier; i++) {
+				bitset_set(frontier_set, frontier[i]);
+			}
+			n_next = bottom_up(c, frontier_set, next, visited,
+					   &edges);
+		} else {
+			n_next = top_down(c, frontier, n_frontier, next,
+					  visited, &edges);
+		}
+		count += n_next;
+
+		int *tmp = frontier;
+		frontier = next;
+		next = tmp;
+		n_frontier = n_next;
+
+		if (dest >= 0 && bitset_test(visited, dest)) {
+			count = -1;
+			break;
+		}
+	}
+
+	free(frontier);
+	free(next);
+	free(frontier_set);
+	if (scanned != NULL) {
+		*scanned += edges;
+	}
+	return count;
+}
+
+/**
+ * claim() - Atomically add a node to a bitset.
+ * @set: Bitset to modify.
+ * @i: Node id.
+ *
+ * Returns: True if the node was not in the set before, otherwise false.
+ */
+static bool claim(uint64_t *set, int i)
+{
+	uint64_t bit = (uint64_t)1 << (i & 63);
+	// A plain load first avoids the atomic for nodes seen long ago.
+	if (__atomic_load_n(&set[i >> 6], __ATOMIC_RELAXED) & bit) {
+		return false;
+	}
+	return !(__atomic_fetch_or(&set[i >> 6], bit, __ATOMIC_RELAXED) & bit);
+}
+
+/**
+ * flush() - Copy the nodes found by a thread to the shared next frontier.
+ * @p: Shared state.
+ * @local: Nodes found by the thread.
+ * @n_local: Number of nodes in local.
+ *
+ * Returns: Nothing.
+ */
+static void flush(struct parallel_bfs *p, const int *local, int n_local)
+{
+	int pos = __atomic_fetch_add(&p->n_next, n_local, __ATOMIC_RELAXED);
+	memcpy(p->next + pos, local, n_local * sizeof(*local));
+}
+
+/**
+ * parallel_worker() - Thread body of the parallel BFS.
+ * @arg: Pointer to a struct parallel_worker.
+ *
+ * Returns: NULL.
+ */
+static void *parallel_worker(void *arg)
+{
+	struct parallel_worker *w = arg;
+	struct parallel_bfs *p = w->shared;
+	const csr_graph *c = p->c;
+	int local[LOCAL_BUFFER];
+
+	// wait until the calling thread has started all threads it could
+	pthread_mutex_lock(&p->start);
+	pthread_mutex_unlock(&p->start);
+
+	while (!p->done) {
+		// Expand this thread's share of the frontier.
+		int first = (long)p->n_frontier * w->thread / p->num_threads;
+		int last = (long)p->n_frontier * (w->thread + 1)
+			/ p->num_threads;
+		int n_local = 0;
+		long edges = 0;
+		for (int i = first; i < last; i++) {
+			int u = p->frontier[i];
+			edges += c->offsets[u + 1] - c->offsets[u];
+			for (int k = c->offsets[u]; k < c->offsets[u + 1];
+			     k++) {
+				int v = c->targets[k];
+				if (!claim(p->visited, v)) {
+					continue;
+				}
+				if (n_local == LOCAL_BUFFER) {
+					flush(p, local, n_local);
+					n_local = 0;
+				}
+				local[n_local++] = v;
+			}
+		}
+		flush(p, local, n_local);
+		__atomic_fetch_add(&p->edges, edges, __ATOMIC_RELAXED);
+		pthread_barrier_wait(&p->barrier);
+
+		// Thread 0 moves on to the next level.
+		if (w->thread == 0) {
+			int *tmp = p->frontier;
+			p->frontier = p->next;
+			p->next = tmp;
+			p->n_frontier = p->n_next;
+			p->count += p->n_next;
+			p->n_next = 0;
+			if (p->n_frontier == 0 || (p->dest >= 0
+				&& bitset_test(p->visited, p->dest))) {
+				p->done = true;
+			}
+		}
+		pthread_barrier_wait(&p->barrier);
+	}
+	return NULL;
+}
+
+/**
+ * parallel() - Multi-threaded level-synchronous BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the node to stop at, or -1 to visit everything.
+ * @visited: Visited set, all zero on entry.
+ * @num_threads: Number of threads to use.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: The number of visited nodes, or -1 if dest was found.
+ */
+static int parallel(const csr_graph *c, int src, int dest, uint64_t *visited,
+		    int num_threads, long *scanned)
+{
+	struct parallel_bfs p = {0};
+	if (num_threads < 1) {
+		num_threads = 1;
+	}
+	p.c = c;
+	p.dest = dest;
+	p.num_threads = num_threads;
+	p.visited = visited;
+	p.frontier = malloc((c->num_nodes + 1) * sizeof(*p.frontier));
+	p.next = malloc((c->num_nodes + 1) * sizeof(*p.next));
+	p.frontier[0] = src;
+	p.n_frontier = 1;
+	pthread_mutex_init(&p.start, NULL);
+	pthread_mutex_lock(&p.start);
+
+	pthread_t *threads = malloc(num_threads * sizeof(*threads));
+	struct parallel_worker *workers = malloc(num_threads
+						 * sizeof(*workers));
+	for (int t = 0; t < num_threads; t++) {
+		workers[t].shared = &p;
+		workers[t].thread = t;
+	}
+	// If a thread can not be created, the frontier is shared by the
+	// threads that did start, at worst only the calling one.
+	int started = 1;
+	while (started < num_threads
+	       && pthread_create(&threads[started], NULL, parallel_worker,
+				 &workers[started]) == 0) {
+		started++;
+	}
+	p.num_threads = started;
+	pthread_barrier_init(&p.barrier, NULL, started);
+	pthread_mutex_unlock(&p.start);
+	parallel_worker(&workers[0]);
+	for (int t = 1; t < started; t++) {
+		pthread_join(threads[t], NULL);
+	}
+
+	pthread_barrier_destroy(&p.barrier);
+	pthread_mutex_destroy(&p.start);
+	free(threads);
+	free(workers);
+	free(p.frontier);
+	free(p.next);
+	if (scanned != NULL) {
+		*scanned += p.edges;
+	}
+	if (dest >= 0 && bitset_test(visited, dest)) {
+		return -1;
+	}
+	return p.count;
+}
+
+/**
+ * bfs_dirop_reach() - Find all nodes reachable from a node with a
+ *		       direction-optimizing BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Bitset of BITSET_WORDS(c->num_nodes) words, all zero on entry.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: The number of reachable nodes, whose bits are set in visited.
+ */
+int bfs_dirop_reach(const csr_graph *c, int src, uint64_t *visited,
+		    long *scanned)
+{
+	return dirop(c, src, -1, visited, scanned);
+}
+
+/**
+ * bfs_dirop_find_path() - See if a path exists between two nodes using
+ *			   a direction-optimizing BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool bfs_dirop_find_path(const csr_graph *c, int src, int dest,
+			 long *scanned)
+{
+	uint64_t *visited = calloc(BITSET_WORDS(c->num_nodes),
+				   sizeof(*visited));
+	bool found = dirop(c, src, dest, visited, scanned) < 0;
+	free(visited);
+	return found;
+}
+
+/**
+ * bfs_parallel_reach() - Find all nodes reachable from a node with a
+ *			  multi-threaded BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Bitset of BITSET_WORDS(c->num_nodes) words, all zero on entry.
+ * @num_threads: Number of threads to use, at least 1.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: The number of reachable nodes, whose bits are set in visited.
+ */
+int bfs_parallel_reach(const csr_graph *c, int src, uint64_t *visited,
+		       int num_threads, long *scanned)
+{
+	return parallel(c, src, -1, visited, num_threads, scanned);
+}
+
+/**
+ * bfs_parallel_find_path() - See if a path exists between two nodes
+ *			      using a multi-threaded BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @num_threads: Number of threads to use, at least 1.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool bfs_parallel_find_path(const csr_graph *c, int src, int dest,
+			    int num_threads, long *scanned)
+{
+	uint64_t *visited = calloc(BITSET_WORDS(c->num_nodes),
+				   sizeof(*visited));
+	bool found = parallel(c, src, dest, visited, num_threads,
+			      scanned) < 0;
+	free(visited);
+	return found;
+}
+
+/**
+ * bfs_multi_reach() - Find the nodes reachable from each of up to
+ *		       BFS_MULTI_MAX sources at once.
+ * @c: Snapshot to inspect.
+ * @sources: Ids of the source nodes.
+ * @num_sources: Number of sources, 1..BFS_MULTI_MAX.
+ * @reach: Array of c->num_nodes masks that receives the result.
+ *
+ * On return, bit j of reach[i] is set if node i can be reached from
+ * sources[j].
+ *
+ * Returns: The total number of reachable (source, node) pairs.
+ */
+long bfs_multi_reach(const csr_graph *c, const int *sources, int num_sources,
+		     uint64_t *reach)
+{
+	// reach doubles as the seen masks; visit holds the searches that
+	// are at each frontier node, next those that reach each node of
+	// the next level. Only the frontier and the nodes it touches are
+	// looked at, so a level costs its own edges and not a pass over all
+	// nodes.
+	uint64_t *visit = calloc(c->num_nodes + 1, sizeof(*visit));
+	uint64_t *next = calloc(c->num_nodes + 1, sizeof(*next));
+	int *frontier = malloc((c->num_nodes + 1) * sizeof(*frontier));
+	int *touched = malloc((c->num_nodes + 1) * sizeof(*touched));
+	int n_frontier = 0;
+	long count = 0;
+
+	memset(reach, 0, c->num_nodes * sizeof(*reach));
+	for (int j = 0; j < num_sources; j++) {
+		if (visit[sources[j]] == 0) {
+			frontier[n_frontier++] = sources[j];
+		}
+		visit[sources[j]] |= (uint64_t)1 << j;
+	}
+
+	while (n_frontier > 0) {
+		// Searches only move on to nodes they have not seen.
+		int n_touched = 0;
+		for (int i = 0; i < n_frontier; i++) {
+			int u = frontier[i];
+			for (int k = c->offsets[u]; k < c->offsets[u + 1];
+			     k++) {
+				int v = c->targets[k];
+				uint64_t found = visit[u] & ~reach[v];
+				if (found != 0) {
+					if (next[v] == 0) {
+						touched[n_touched++] = v;
+					}
+					next[v] |= found;
+				}
+			}
+			visit[u] = 0;
+		}
+
+		// reach is not changed while a level is expanded, so the
+		// touched nodes are exactly the next frontier
+		for (int i = 0; i < n_touched; i++) {
+			int v = touched[i];
+			reach[v] |= next[v];
+			visit[v] = next[v];
+			count += __builtin_popcountll(next[v]);
+			next[v] = 0;
+		}
+		int *swap = frontier;
+		frontier = touched;
+		touched = swap;
+		n_frontier = n_touched;
+	}
+
+	free(visit);
+	free(next);
+	free(frontier);
+	free(touched);
+	return count;
+}
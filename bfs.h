@@ -0,0 +1,145 @@
+#ifndef __BFS_H
+#define __BFS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "csr.h"
+
+/*
+ * Declaration of breadth-first search engines for CSR snapshots of
+ * graphs (see csr.h). Sets of nodes are stored as bitsets of 64-bit
+ * words, where node i is bit i%64 of word i/64. A bitset for a snapshot
+ * c holds BITSET_WORDS(c->num_nodes) words.
+ *
+ * As for csr_reach(), a node counts as reachable from a source if there
+ * is a path of at least one edge to it, so the source itself is only
+ * reachable if it lies on a cycle.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Number of 64-bit words in a bitset of n nodes.
+#define BITSET_WORDS(n) (((n) + 63) / 64)
+
+// Maximum number of sources of one bfs_multi_reach() call.
+#define BFS_MULTI_MAX 64
+
+// ==========BITSET HELPERS==========
+
+/**
+ * bitset_test() - Check whether a node is in a bitset.
+ * @set: Bitset to inspect.
+ * @i: Node id.
+ *
+ * Returns: True if node i is in the set, otherwise false.
+ */
+static inline bool bitset_test(const uint64_t *set, int i)
+{
+	return (set[i >> 6] >> (i & 63)) & 1;
+}
+
+/**
+ * bitset_set() - Add a node to a bitset.
+ * @set: Bitset to modify.
+ * @i: Node id.
+ *
+ * Returns: Nothing.
+ */
+static inline void bitset_set(uint64_t *set, int i)
+{
+	set[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+// ==========SEARCH INTERFACE==========
+
+/**
+ * bfs_dirop_reach() - Find all nodes reachable from a node with a
+ *		       direction-optimizing BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Bitset of BITSET_WORDS(c->num_nodes) words, all zero on entry.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Each BFS level is expanded either top-down, by following the
+ * out-edges of the frontier, or bottom-up, by checking the in-edges of
+ * every unvisited node for a frontier node. The search turns bottom-up
+ * once the out-edges of the frontier exceed 1/ALPHA of the edges not yet
+ * explored, and back top-down once the frontier holds fewer than 1/BETA
+ * of the nodes (ALPHA and BETA are set in bfs.c). This saves most of the
+ * edge checks on low-diameter graphs.
+ *
+ * Returns: The number of reachable nodes, whose bits are set in visited.
+ */
+int bfs_dirop_reach(const csr_graph *c, int src, uint64_t *visited,
+		    long *scanned);
+
+/**
+ * bfs_dirop_find_path() - See if a path exists between two nodes using
+ *			   a direction-optimizing BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool bfs_dirop_find_path(const csr_graph *c, int src, int dest,
+			 long *scanned);
+
+/**
+ * bfs_parallel_reach() - Find all nodes reachable from a node with a
+ *			  multi-threaded BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Bitset of BITSET_WORDS(c->num_nodes) words, all zero on entry.
+ * @num_threads: Number of threads to use, at least 1.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * The BFS is level-synchronous: the frontier of each level is split
+ * into equal parts, one per thread, and the threads claim newly found
+ * nodes with an atomic test-and-set on the visited bitset.
+ *
+ * Returns: The number of reachable nodes, whose bits are set in visited.
+ */
+int bfs_parallel_reach(const csr_graph *c, int src, uint64_t *visited,
+		       int num_threads, long *scanned);
+
+/**
+ * bfs_parallel_find_path() - See if a path exists between two nodes
+ *			      using a multi-threaded BFS.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @num_threads: Number of threads to use, at least 1.
+ * @scanned: If not NULL, the number of edges looked at is added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool bfs_parallel_find_path(const csr_graph *c, int src, int dest,
+			    int num_threads, long *scanned);
+
+/**
+ * bfs_multi_reach() - Find the nodes reachable from each of up to
+ *		       BFS_MULTI_MAX sources at once.
+ * @c: Snapshot to inspect.
+ * @sources: Ids of the source nodes.
+ * @num_sources: Number of sources, 1..BFS_MULTI_MAX.
+ * @reach: Array of c->num_nodes masks that receives the result.
+ *
+ * Runs one BFS per source in a single pass over the graph (MS-BFS,
+ * Then et al., VLDB 2014). Every node holds a 64-bit mask with one bit
+ * per source, so one scan of an adjacency list advances all searches
+ * that are at the node in the same level. Only the nodes of the frontier
+ * are scanned, so a level costs the edges it expands.
+ *
+ * On return, bit j of reach[i] is set if node i can be reached from
+ * sources[j].
+ *
+ * Returns: The total number of reachable (source, node) pairs.
+ */
+long bfs_multi_reach(const csr_graph *c, const int *sources, int num_sources,
+		     uint64_t *reach);
+
+#endif
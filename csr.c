@@ -0,0 +1,454 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csr.h"
+
+/*
+ * Implementation of traversals on the immutable CSR snapshot of a
+ * graph. The snapshot itself is built by graph_freeze() in graph.c.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+// Search side flags used by the bidirectional search.
+#define FORWARD 1
+#define BACKWARD 2
+
+/*
+ * Every search takes three consecutive stamps, from base on. A node the
+ * search has marked holds base + flags - 1, where flags are the sides
+ * (FORWARD, BACKWARD or both) that reached it, so a stamp of an earlier
+ * search reads as no flags at all.
+ */
+struct csr_scratch {
+	int num_nodes;
+	unsigned int *stamp;
+	unsigned int last;	// Last stamp taken.
+	int *queue;		// Forward and backward queue, num_nodes each.
+	int *links;		// Node each marked node was reached from.
+};
+
+// Number of blocks allocated by a temporary scratch.
+#define SCRATCH_ALLOCATIONS 4
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * count() - Add the work of a search to the counters of a query.
+ * @counters: Counters to update, or NULL.
+ * @dequeued: Number of nodes taken from the queue.
+ * @edges: Number of edges looked at.
+ * @peak: Largest number of nodes queued at once.
+ * @allocations: Number of blocks allocated.
+ *
+ * Returns: Nothing.
+ */
+static void count(query_counters *counters, long dequeued, long edges,
+		  long peak, long allocations)
+{
+	if (counters == NULL) {
+		return;
+	}
+	counters->dequeued += dequeued;
+	counters->scanned += edges;
+	if (peak > counters->peak_queue) {
+		counters->peak_queue = peak;
+	}
+	counters->allocations += allocations;
+}
+
+/**
+ * bfs() - Breadth-first search over a snapshot.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the node to stop at, or -1 to visit everything.
+ * @visited: Array of num_nodes flags, all false on entry.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: The number of visited nodes, or -1 if dest was found.
+ */
+static int bfs(const csr_graph *c, int src, int dest, bool *visited,
+	       query_counters *counters)
+{
+	// Every node enters the queue at most once, so a plain array of
+	// num_nodes entries is enough.
+	int *queue = malloc(c->num_nodes * sizeof(*queue));
+	int head = 0;
+	int tail = 0;
+	int found = 0;
+	int current = src;
+	long edges = 0;
+	int peak = 0;
+
+	// The source is expanded first but is only marked visited if it
+	// is reached again.
+	for (;;) {
+		for (int k = c->offsets[current]; k < c->offsets[current + 1];
+		     k++) {
+			int v = c->targets[k];
+			edges++;
+			if (v == dest) {
+				free(queue);
+				count(counters, head + 1, edges, peak, 1);
+				return -1;
+			}
+			if (!visited[v]) {
+				visited[v] = true;
+				queue[tail++] = v;
+				found++;
+			}
+		}
+		if (tail - head > peak) {
+			peak = tail - head;
+		}
+		if (head == tail) {
+			break;
+		}
+		current = queue[head++];
+	}
+
+	free(queue);
+	count(counters, head + 1, edges, peak, 1);
+	return found;
+}
+
+/**
+ * begin() - Take the stamps of a new search.
+ * @s: Scratch to search with.
+ *
+ * Returns: The first of the three stamps of the search.
+ */
+static unsigned int begin(csr_scratch *s)
+{
+	// when the stamps run out, all nodes are unmarked once
+	if (s->last > UINT_MAX - 3) {
+		memset(s->stamp, 0, s->num_nodes * sizeof(*s->stamp));
+		s->last = 0;
+	}
+	unsigned int base = s->last + 1;
+	s->last += 3;
+	return base;
+}
+
+/**
+ * flags_of() - Return the sides of the current search that reached a
+ *		node.
+ * @s: Scratch of the search.
+ * @base: First stamp of the search.
+ * @v: Id of the node.
+ *
+ * Returns: FORWARD and/or BACKWARD, or 0 if the node is not marked.
+ */
+static unsigned char flags_of(const csr_scratch *s, unsigned int base, int v)
+{
+	unsigned int d = s->stamp[v] - base;
+	return d < 3 ? d + 1 : 0;
+}
+
+/**
+ * mark() - Mark a node as reached by a side of the current search.
+ * @s: Scratch of the search.
+ * @base: First stamp of the search.
+ * @v: Id of the node.
+ * @side: FORWARD or BACKWARD.
+ *
+ * Returns: Nothing.
+ */
+static void mark(csr_scratch *s, unsigned int base, int v, unsigned char side)
+{
+	s->stamp[v] = base + (flags_of(s, base, v) | side) - 1;
+}
+
+/**
+ * expand_level() - Expand one BFS level of one side of a bidirectional
+ *		    search.
+ * @offsets: Edge offsets to follow (out-edges forward, in-edges backward).
+ * @ends: Edge end points matching offsets.
+ * @s: Scratch holding the side flags of each node.
+ * @base: First stamp of the search.
+ * @side: Side being expanded, FORWARD or BACKWARD.
+ * @queue: Queue of the side, the current level is queue[*head..*tail-1].
+ * @head: Start of the current level, set to the start of the next level.
+ * @tail: End of the current level, set to the end of the next level.
+ * @edges: Number of edges looked at, updated.
+ * @meet: Set to the ends of the edge that joined the sides, in the
+ * direction of the path.
+ *
+ * Every node marked by the side gets the node it was reached from in
+ * s->links, so each side can be read back to where it started.
+ *
+ * Returns: True if the two sides met, otherwise false.
+ */
+static bool expand_level(const int *offsets, const int *ends,
+			 csr_scratch *s, unsigned int base, unsigned char side,
+			 int *queue, int *head, int *tail, long *edges,
+			 int *meet)
+{
+	unsigned char other = side == FORWARD ? BACKWARD : FORWARD;
+	int end = *tail;
+
+	for (int i = *head; i < end; i++) {
+		int u = queue[i];
+		for (int k = offsets[u]; k < offsets[u + 1]; k++) {
+			int v = ends[k];
+			(*edges)++;
+			// The edge joins the two searches into a path.
+			unsigned char flags = flags_of(s, base, v);
+			if (flags & other) {
+				meet[0] = side == FORWARD ? u : v;
+				meet[1] = side == FORWARD ? v : u;
+				return true;
+			}
+			if (!(flags & side)) {
+				mark(s, base, v, side);
+				s->links[v] = u;
+				queue[(*tail)++] = v;
+			}
+		}
+	}
+	*head = end;
+	return false;
+}
+
+/**
+ * csr_reach() - Find all nodes reachable from a node.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Array of num_nodes flags, all false on entry.
+ *
+ * Runs a breadth-first search from src and sets visited[i] for every
+ * node i that can be reached by a path of at least one edge. src itself
+ * is only marked if it lies on a cycle.
+ *
+ * Returns: The number of reachable nodes.
+ */
+int csr_reach(const csr_graph *c, int src, bool *visited)
+{
+	return bfs(c, src, -1, visited, NULL);
+}
+
+/**
+ * csr_scratch_empty() - Create the search state for a snapshot.
+ * @c: Snapshot the scratch is used with.
+ *
+ * Returns: A pointer to the new scratch.
+ */
+csr_scratch *csr_scratch_empty(const csr_graph *c)
+{
+	csr_scratch *s = malloc(sizeof(*s));
+	s->num_nodes = c->num_nodes;
+	s->stamp = calloc(c->num_nodes + 1, sizeof(*s->stamp));
+	s->last = 0;
+	s->queue = malloc((2 * c->num_nodes + 1) * sizeof(*s->queue));
+	s->links = malloc((c->num_nodes + 1) * sizeof(*s->links));
+	return s;
+}
+
+/**
+ * csr_find_path() - See if a path exists between two nodes.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL to use a temporary one.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool csr_find_path(const csr_graph *c, int src, int dest,
+		   csr_scratch *scratch, query_counters *counters)
+{
+	csr_scratch *s = scratch != NULL ? scratch : csr_scratch_empty(c);
+	unsigned int base = begin(s);
+	int *queue = s->queue;
+	int head = 0;
+	int tail = 0;
+	int current = src;
+	long edges = 0;
+	int peak = 0;
+	bool found = false;
+
+	// The source is expanded first but is only marked if it is
+	// reached again.
+	for (;;) {
+		for (int k = c->offsets[current]; k < c->offsets[current + 1];
+		     k++) {
+			int v = c->targets[k];
+			edges++;
+			if (v == dest) {
+				found = true;
+				break;
+			}
+			if (flags_of(s, base, v) == 0) {
+				mark(s, base, v, FORWARD);
+				queue[tail++] = v;
+			}
+		}
+		if (tail - head > peak) {
+			peak = tail - head;
+		}
+		if (found || head == tail) {
+			break;
+		}
+		current = queue[head++];
+	}
+
+	if (scratch == NULL) {
+		csr_scratch_kill(s);
+	}
+	count(counters, head + 1, edges, peak,
+	      scratch == NULL ? SCRATCH_ALLOCATIONS : 0);
+	return found;
+}
+
+/**
+ * bidir() - Search from both ends of a path at once.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL to use a temporary one.
+ * @route: If not NULL, filled in with the ids of the path, src first and
+ * dest last.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: 0 if there is no path, otherwise the number of nodes of the
+ * route, or 1 if route is NULL.
+ */
+static int bidir(const csr_graph *c, int src, int dest, csr_scratch *scratch,
+		 int *route, query_counters *counters)
+{
+	// Every edge expansion adds an edge to the path, so the two sides
+	// only meet on paths of at least one edge, also when src == dest.
+	csr_scratch *s = scratch != NULL ? scratch : csr_scratch_empty(c);
+	unsigned int base = begin(s);
+	int *fwd = s->queue;
+	int *bwd = s->queue + c->num_nodes;
+	int fwd_head = 0, fwd_tail = 1;
+	int bwd_head = 0, bwd_tail = 1;
+	long edges = 0;
+	int peak = 2;
+	bool found = false;
+	int meet[2];
+
+	fwd[0] = src;
+	bwd[0] = dest;
+	mark(s, base, src, FORWARD);
+	mark(s, base, dest, BACKWARD);
+
+	// Stop when either side runs out of nodes.
+	while (!found && fwd_head < fwd_tail && bwd_head < bwd_tail) {
+		if (fwd_tail - fwd_head <= bwd_tail - bwd_head) {
+			found = expand_level(c->offsets, c->targets, s, base,
+					     FORWARD, fwd, &fwd_head,
+					     &fwd_tail, &edges, meet);
+		} else {
+			found = expand_level(c->in_offsets, c->sources, s,
+					     base, BACKWARD, bwd, &bwd_head,
+					     &bwd_tail, &edges, meet);
+		}
+		if (fwd_tail - fwd_head + bwd_tail - bwd_head > peak) {
+			peak = fwd_tail - fwd_head + bwd_tail - bwd_head;
+		}
+	}
+
+	// The forward side is read back from the joining edge to src and
+	// the backward side on to dest.
+	int length = found ? 1 : 0;
+	if (found && route != NULL) {
+		for (int v = meet[0]; v != src; v = s->links[v]) {
+			length++;
+		}
+		int v = meet[0];
+		for (int i = length - 1; i > 0; i--) {
+			route[i] = v;
+			v = s->links[v];
+		}
+		route[0] = src;
+		for (v = meet[1]; ; v = s->links[v]) {
+			route[length++] = v;
+			if (v == dest) {
+				break;
+			}
+		}
+	}
+
+	if (scratch == NULL) {
+		csr_scratch_kill(s);
+	}
+	// the nodes of the finished levels were taken from the queues
+	count(counters, fwd_head + bwd_head, edges, peak,
+	      scratch == NULL ? SCRATCH_ALLOCATIONS : 0);
+	return length;
+}
+
+/**
+ * csr_find_path_bidir() - See if a path exists between two nodes using
+ *			   a bidirectional search.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL to use a temporary one.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Searches forward from src along out-edges and backward from dest
+ * along in-edges, one BFS level at a time, always expanding the side
+ * with the smaller frontier. Gives the same answer as csr_find_path().
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool csr_find_path_bidir(const csr_graph *c, int src, int dest,
+			 csr_scratch *scratch, query_counters *counters)
+{
+	return bidir(c, src, dest, scratch, NULL, counters) > 0;
+}
+
+/**
+ * csr_route_bidir() - Find a path between two nodes using a
+ *		       bidirectional search.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL to use a temporary one.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int csr_route_bidir(const csr_graph *c, int src, int dest,
+		    csr_scratch *scratch, int *route, query_counters *counters)
+{
+	return bidir(c, src, dest, scratch, route, counters);
+}
+
+/**
+ * csr_kill() - Destroy a given snapshot.
+ * @c: Snapshot to destroy.
+ *
+ * Returns: Nothing.
+ */
+void csr_kill(csr_graph *c)
+{
+	free(c->offsets);
+	free(c->targets);
+	free(c->weights);
+	free(c->in_offsets);
+	free(c->sources);
+	free(c->nodes);
+	free(c);
+}
+
+/**
+ * csr_scratch_kill() - Destroy a given scratch.
+ * @s: Scratch to destroy.
+ *
+ * Returns: Nothing.
+ */
+void csr_scratch_kill(csr_scratch *s)
+{
+	free(s->stamp);
+	free(s->queue);
+	free(s->links);
+	free(s);
+}
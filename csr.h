@@ -0,0 +1,144 @@
+#ifndef __CSR_H
+#define __CSR_H
+
+#include <stdbool.h>
+#include "graph.h"
+#include "query_stats.h"
+
+/*
+ * Declaration of an immutable compressed sparse row (CSR) snapshot of
+ * a graph. The snapshot is built from a graph with graph_freeze() and
+ * stores the edges of all nodes in one contiguous array, so traversals
+ * do not have to follow a pointer per edge. The out-neighbours of the
+ * node with id i are
+ *
+ *   targets[offsets[i]], ..., targets[offsets[i+1]-1]
+ *
+ * with the weights of those edges at the same positions of weights,
+ * and, in the same way, its in-neighbours are
+ *
+ *   sources[in_offsets[i]], ..., sources[in_offsets[i+1]-1]
+ *
+ * Point-to-point searches keep their per-node state in a csr_scratch
+ * made once for the snapshot. Its entries are stamped with the query
+ * that wrote them, so a search neither allocates nor clears O(V) memory.
+ *
+ * After use, the function csr_kill() must be called to de-allocate the
+ * dynamic memory used by the snapshot, and csr_scratch_kill() for each
+ * scratch.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+struct csr_graph {
+	int num_nodes;		// Number of nodes, ids are 0..num_nodes-1.
+	int num_edges;		// Number of edges.
+	int *offsets;		// Start of the edges of each node, num_nodes+1.
+	int *targets;		// Destination id of each edge, num_edges.
+	int *weights;		// Weight of each edge, num_edges.
+	int *in_offsets;	// Start of the in-edges of each node.
+	int *sources;		// Source id of each in-edge, num_edges.
+	node **nodes;		// Graph node of each id.
+};
+
+// Reusable state of the searches of one thread on one snapshot.
+typedef struct csr_scratch csr_scratch;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * csr_reach() - Find all nodes reachable from a node.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @visited: Array of num_nodes flags, all false on entry.
+ *
+ * Runs a breadth-first search from src and sets visited[i] for every
+ * node i that can be reached by a path of at least one edge. src itself
+ * is only marked if it lies on a cycle.
+ *
+ * Returns: The number of reachable nodes.
+ */
+int csr_reach(const csr_graph *c, int src, bool *visited);
+
+/**
+ * csr_scratch_empty() - Create the search state for a snapshot.
+ * @c: Snapshot the scratch is used with.
+ *
+ * Returns: A pointer to the new scratch.
+ */
+csr_scratch *csr_scratch_empty(const csr_graph *c);
+
+/**
+ * csr_find_path() - See if a path exists between two nodes.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c by csr_scratch_empty(), or NULL to use a
+ * temporary one for this search only.
+ * @counters: If not NULL, the nodes dequeued, edges scanned, peak queue
+ * depth and allocations of the search are added to it.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool csr_find_path(const csr_graph *c, int src, int dest,
+		   csr_scratch *scratch, query_counters *counters);
+
+/**
+ * csr_find_path_bidir() - See if a path exists between two nodes using
+ *			   a bidirectional search.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL, as for csr_find_path().
+ * @counters: If not NULL, the work of the search is added to it as by
+ * csr_find_path().
+ *
+ * Searches forward from src along out-edges and backward from dest
+ * along in-edges, one BFS level at a time, always expanding the side
+ * with the smaller frontier. Gives the same answer as csr_find_path().
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool csr_find_path_bidir(const csr_graph *c, int src, int dest,
+			 csr_scratch *scratch, query_counters *counters);
+
+/**
+ * csr_route_bidir() - Find a path between two nodes using a
+ *		       bidirectional search.
+ * @c: Snapshot to inspect.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @scratch: Scratch made for c, or NULL, as for csr_find_path().
+ * @route: Filled in with the ids of the path, src first and dest last,
+ * room for c->num_nodes + 1 ids.
+ * @counters: If not NULL, the work of the search is added to it as by
+ * csr_find_path().
+ *
+ * Runs the search of csr_find_path_bidir(), which keeps the node each
+ * node was reached from, and joins the two halves of the path where the
+ * sides met. The path has the fewest edges.
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int csr_route_bidir(const csr_graph *c, int src, int dest,
+		    csr_scratch *scratch, int *route, query_counters *counters);
+
+/**
+ * csr_kill() - Destroy a given snapshot.
+ * @c: Snapshot to destroy.
+ *
+ * Returns: Nothing.
+ */
+void csr_kill(csr_graph *c);
+
+/**
+ * csr_scratch_kill() - Destroy a given scratch.
+ * @s: Scratch to destroy.
+ *
+ * Returns: Nothing.
+ */
+void csr_scratch_kill(csr_scratch *s);
+
+#endif
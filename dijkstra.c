@@ -0,0 +1,253 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dijkstra.h"
+#include "path.h"
+
+/*
+ * Implementation of Dijkstra's algorithm with a 4-ary heap on a CSR
+ * snapshot.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+// Children per heap entry.
+#define ARITY 4
+
+/*
+ * Entry of the heap. The distance is kept next to the node, so sifting
+ * compares entries without looking up the distance array.
+ */
+typedef struct {
+	long dist;
+	int node;
+} heap_entry;
+
+/*
+ * A node has been reached by the current query when its stamp equals
+ * the query number. pos[v] is then its index in the heap, or -1 once it
+ * has been taken from the heap and its distance is final, and
+ * parents[v] is the node of its best known path.
+ */
+struct dijkstra {
+	const csr_graph *c;
+	long *dist;
+	unsigned int *stamp;
+	unsigned int query;
+	int *pos;
+	int *parents;
+	heap_entry *heap;
+	int size;
+	int peak;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * place() - Put an entry at a position of the heap.
+ * @d: Engine to modify.
+ * @i: Position in the heap.
+ * @e: Entry to put there.
+ *
+ * Returns: Nothing.
+ */
+static void place(dijkstra *d, int i, heap_entry e)
+{
+	d->heap[i] = e;
+	d->pos[e.node] = i;
+}
+
+/**
+ * sift_up() - Move an entry towards the root until its parent is not
+ *	       larger.
+ * @d: Engine to modify.
+ * @i: Position of the entry.
+ *
+ * Returns: Nothing.
+ */
+static void sift_up(dijkstra *d, int i)
+{
+	heap_entry e = d->heap[i];
+	while (i > 0) {
+		int parent = (i - 1) / ARITY;
+		if (d->heap[parent].dist <= e.dist) {
+			break;
+		}
+		place(d, i, d->heap[parent]);
+		i = parent;
+	}
+	place(d, i, e);
+}
+
+/**
+ * sift_down() - Move an entry towards the leaves until no child is
+ *		 smaller.
+ * @d: Engine to modify.
+ * @i: Position of the entry.
+ *
+ * Returns: Nothing.
+ */
+static void sift_down(dijkstra *d, int i)
+{
+	heap_entry e = d->heap[i];
+	for (;;) {
+		int first = ARITY * i + 1;
+		if (first >= d->size) {
+			break;
+		}
+		int last = first + ARITY < d->size ? first + ARITY : d->size;
+		int min = first;
+		for (int k = first + 1; k < last; k++) {
+			if (d->heap[k].dist < d->heap[min].dist) {
+				min = k;
+			}
+		}
+		if (d->heap[min].dist >= e.dist) {
+			break;
+		}
+		place(d, i, d->heap[min]);
+		i = min;
+	}
+	place(d, i, e);
+}
+
+/**
+ * relax() - Offer the out-neighbours of a node their distance through it.
+ * @d: Engine to modify.
+ * @u: Id of the node.
+ * @du: Distance of u.
+ *
+ * Returns: The number of edges looked at.
+ */
+static long relax(dijkstra *d, int u, long du)
+{
+	const csr_graph *c = d->c;
+	for (int k = c->offsets[u]; k < c->offsets[u + 1]; k++) {
+		int v = c->targets[k];
+		long dv = du + c->weights[k];
+		if (d->stamp[v] != d->query) {
+			d->stamp[v] = d->query;
+			d->dist[v] = dv;
+			d->parents[v] = u;
+			heap_entry e = {dv, v};
+			place(d, d->size++, e);
+			sift_up(d, d->size - 1);
+		} else if (d->pos[v] >= 0 && dv < d->dist[v]) {
+			d->dist[v] = dv;
+			d->parents[v] = u;
+			d->heap[d->pos[v]].dist = dv;
+			sift_up(d, d->pos[v]);
+		}
+	}
+	if (d->size > d->peak) {
+		d->peak = d->size;
+	}
+	return c->offsets[u + 1] - c->offsets[u];
+}
+
+/**
+ * dijkstra_empty() - Create a shortest-path engine for a snapshot.
+ * @c: Snapshot to search, its weights must be at least 0.
+ *
+ * Returns: A pointer to the new engine.
+ */
+dijkstra *dijkstra_empty(const csr_graph *c)
+{
+	dijkstra *d = malloc(sizeof(*d));
+	d->c = c;
+	d->dist = malloc((c->num_nodes + 1) * sizeof(*d->dist));
+	d->stamp = calloc(c->num_nodes + 1, sizeof(*d->stamp));
+	d->query = 0;
+	d->pos = malloc((c->num_nodes + 1) * sizeof(*d->pos));
+	d->parents = malloc((c->num_nodes + 1) * sizeof(*d->parents));
+	d->heap = malloc((c->num_nodes + 1) * sizeof(*d->heap));
+	d->size = 0;
+	return d;
+}
+
+/**
+ * dijkstra_distance() - Find the length of a shortest path.
+ * @d: Engine to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: The sum of the weights of the cheapest path from src to
+ * dest, or -1 if there is no such path.
+ */
+long dijkstra_distance(dijkstra *d, int src, int dest,
+		       query_counters *counters)
+{
+	// a new query number makes all nodes unreached at once
+	if (++d->query == 0) {
+		memset(d->stamp, 0, d->c->num_nodes * sizeof(*d->stamp));
+		d->query = 1;
+	}
+	d->size = 0;
+	d->peak = 0;
+
+	// the source is not reached by itself, only by a cycle through it
+	long edges = relax(d, src, 0);
+	long dequeued = 0;
+	long found = -1;
+	while (d->size > 0) {
+		heap_entry min = d->heap[0];
+		d->pos[min.node] = -1;
+		if (--d->size > 0) {
+			place(d, 0, d->heap[d->size]);
+			sift_down(d, 0);
+		}
+		dequeued++;
+		if (min.node == dest) {
+			found = min.dist;
+			break;
+		}
+		edges += relax(d, min.node, min.dist);
+	}
+
+	if (counters != NULL) {
+		counters->dequeued += dequeued;
+		counters->scanned += edges;
+		if (d->peak > counters->peak_queue) {
+			counters->peak_queue = d->peak;
+		}
+	}
+	return found;
+}
+
+/**
+ * dijkstra_route() - Find a cheapest path and its hops.
+ * @d: Engine to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ * @cost: Set to the sum of the weights of the path, or -1.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int dijkstra_route(dijkstra *d, int src, int dest, int *route, long *cost,
+		   query_counters *counters)
+{
+	*cost = dijkstra_distance(d, src, dest, counters);
+	if (*cost < 0) {
+		return 0;
+	}
+	return path_unwind(d->parents, src, dest, route);
+}
+
+/**
+ * dijkstra_kill() - Destroy a given engine.
+ * @d: Engine to destroy.
+ *
+ * Returns: Nothing.
+ */
+void dijkstra_kill(dijkstra *d)
+{
+	free(d->dist);
+	free(d->stamp);
+	free(d->pos);
+	free(d->parents);
+	free(d->heap);
+	free(d);
+}
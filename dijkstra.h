@@ -0,0 +1,80 @@
+#ifndef __DIJKSTRA_H
+#define __DIJKSTRA_H
+
+#include "csr.h"
+#include "query_stats.h"
+
+/*
+ * Declaration of a shortest-path engine for the weighted edges of a CSR
+ * snapshot. The engine runs Dijkstra's algorithm with a 4-ary heap of
+ * (distance, node) pairs kept in one array, so a heap operation touches
+ * few cache lines and nothing is allocated per query.
+ *
+ * All per-node state is stamped with the query that wrote it, so one
+ * engine answers any number of queries without clearing its arrays in
+ * between. The parent of every reached node is kept as well, so the
+ * hops of a cheapest path are read back without another search.
+ *
+ * After use, the function dijkstra_kill() must be called to de-allocate
+ * the dynamic memory used by the engine. The engine does not own the
+ * snapshot, which must outlive it.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Engine type.
+typedef struct dijkstra dijkstra;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * dijkstra_empty() - Create a shortest-path engine for a snapshot.
+ * @c: Snapshot to search, its weights must be at least 0.
+ *
+ * Returns: A pointer to the new engine.
+ */
+dijkstra *dijkstra_empty(const csr_graph *c);
+
+/**
+ * dijkstra_distance() - Find the length of a shortest path.
+ * @d: Engine to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @counters: If not NULL, the nodes taken from the heap, edges scanned
+ * and peak heap size of the search are added to it.
+ *
+ * Only paths of at least one edge count, as for csr_find_path(), so the
+ * distance from a node to itself is the length of its shortest cycle.
+ *
+ * Returns: The sum of the weights of the cheapest path from src to
+ * dest, or -1 if there is no such path.
+ */
+long dijkstra_distance(dijkstra *d, int src, int dest,
+		       query_counters *counters);
+
+/**
+ * dijkstra_route() - Find a cheapest path and its hops.
+ * @d: Engine to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last,
+ * num_nodes + 1 ids is always enough.
+ * @cost: Set to the sum of the weights of the path, or -1 if there is no
+ * path.
+ * @counters: If not NULL, the work of the search is added to it as by
+ * dijkstra_distance().
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int dijkstra_route(dijkstra *d, int src, int dest, int *route, long *cost,
+		   query_counters *counters);
+
+/**
+ * dijkstra_kill() - Destroy a given engine.
+ * @d: Engine to destroy.
+ *
+ * Returns: Nothing.
+ */
+void dijkstra_kill(dijkstra *d);
+
+#endif
@@ -1,10 +1,21 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "graph.h"
+#include "csr.h"
 #include "dlist.h"
 #include "list.h"
+#include "arena.h"
+#include "reach_cache.h"
+#include "reorder.h"
 #include "util.h"
 /*
  * Implementation of directed graph with adjacency list representation
@@ -18,14 +29,400 @@ int num_of_nodes;
 
  // ===========INTERNAL DATA TYPES============
 
+ /*
+  * An edge is one record that is linked into the out-list of its source
+  * and into the in-list of its target. The record is its own position
+  * in both lists, so it can be unlinked from them in constant time.
+  */
+ struct edge{
+   node *from;
+   node *to;
+   int weight;
+   edge *out_next;
+   edge *out_prev;
+   edge *in_next;
+   edge *in_prev;
+ };
+
  struct node{
-   dlist *neighbours;
+   edge *out;
+   edge *in;
+   int out_degree;
+   int in_degree;
     char *name;
-   bool seen;
+   unsigned int seen;
+   unsigned int hash;
+   int id;
+   // union-find forest of undirected graphs
+   node *parent;
+   int rank;
+   bool linked;
  };
 
+ /*
+  * Besides the list of nodes the graph keeps an open-addressing hash
+  * index (linear probing) from node name to node, so that
+  * graph_find_node() does not have to scan the node list. The index
+  * size is always a power of two and is kept at most half full.
+  *
+  * A node is seen when its seen stamp equals the current epoch of the
+  * graph, so resetting the seen status of all nodes is done by starting
+  * a new epoch instead of visiting every node.
+  *
+  * The nodes are also kept in an array indexed by node id. Ids are not
+  * reused, so the slot of a deleted node stays NULL.
+  *
+  * The nodes and edges are allocated from the arena of the graph, so
+  * they are all returned by one arena_kill(), and the memory of deleted
+  * ones is reused by later insertions. The node names are interned:
+  * each name is stored once, packed into the chunks of a separate names
+  * arena, and the hash index maps it to its node.
+  *
+  * An undirected graph also keeps its nodes in a union-find forest, so
+  * that two nodes are connected exactly when they have the same root.
+  * The forest is updated by every graph_insert_edge(). A forest cannot
+  * be split, so deletions only mark it stale and it is rebuilt from the
+  * edges at the next graph_nodes_connected().
+  *
+  * The generation counts the changes of the graph. Answers in the
+  * reachability cache are stamped with the generation they were computed
+  * on, so any change makes all of them stale at once.
+  */
  struct graph{
-   dlist *nodes;
+   arena *arena;
+   arena *names;
+   node **nodes;
+   int nodes_size;
+   unsigned int epoch;
+   node **index;
+   int index_size;
+   int index_count;
+   int node_count;
+   int edge_count;
+   bool undirected;
+   bool components_stale;
+   unsigned int generation;
+   reach_cache *cache;
+   query_stats *stats;
+ };
+
+ /*
+  * A binary snapshot is this header followed by arrays of 32-bit words,
+  * the first three of them laid out as in a CSR snapshot, so that a
+  * mapped file is copied into one without parsing:
+  *
+  *   int offsets[num_nodes + 1]		out-edges of each node, as in CSR
+  *   int targets[num_edges]		destination id of each edge
+  *   int weights[num_edges]		weight of each edge
+  *   int name_offsets[num_nodes + 1]	start of each name in names
+  *   unsigned int hashes[num_nodes]	hash of each name
+  *   char names[names_size]		'\0'-terminated names
+  *
+  * A deleted node has an empty slot in names. names_size is padded to a
+  * multiple of 4, and the checksum is FNV-1a over the words after the
+  * header.
+  */
+ typedef struct{
+   char magic[8];
+   int version;
+   int num_nodes;
+   int num_edges;
+   int names_size;
+   unsigned int checksum;
+   int reserved;
+ } snapshot_header;
+
+ #define SNAPSHOT_MAGIC "GRAPHSNP"
+ #define SNAPSHOT_VERSION 2
+
+
+ // ===========INTERNAL HELPER FUNCTIONS============
+
+ /**
+  * hash_name() - Compute the hash value for a node name (FNV-1a).
+  * @s: Node name, need not be null-terminated.
+  * @len: Length of the name.
+  *
+  * Returns: The hash value.
+  */
+ static unsigned int hash_name(const char *s, size_t len){
+   unsigned int h = 2166136261u;
+   for(size_t i = 0; i < len; i++){
+     h ^= (unsigned char)s[i];
+     h *= 16777619u;
+   };
+   return h;
+ };
+
+ /**
+  * index_insert() - Put a node into the first free slot of its probe
+  * sequence in the hash index.
+  * @index: Hash index to modify.
+  * @size: Size of the index (power of two).
+  * @n: Node to insert.
+  *
+  * Returns: Nothing.
+  */
+ static void index_insert(node **index, int size, node *n){
+   unsigned int mask = size - 1;
+   unsigned int slot = n->hash & mask;
+   while(index[slot] != NULL){
+     slot = (slot + 1) & mask;
+   };
+   index[slot] = n;
+ };
+
+ /**
+  * index_grow() - Double the size of the hash index and rehash all nodes.
+  * @g: Graph to modify.
+  *
+  * Returns: Nothing.
+  */
+ static void index_grow(graph *g){
+   int new_size = 2 * g->index_size;
+   node **new_index = calloc(new_size, sizeof(*new_index));
+
+   for(int i = 0; i < g->index_size; i++){
+     if(g->index[i] != NULL){
+       index_insert(new_index, new_size, g->index[i]);
+     };
+   };
+
+   free(g->index);
+   g->index = new_index;
+   g->index_size = new_size;
+ };
+
+ /**
+  * index_remove() - Remove a node from the hash index.
+  * @g: Graph to modify.
+  * @n: Node to remove, must be in the index.
+  *
+  * The nodes after the emptied slot are shifted back into it when their
+  * probe sequence passes it, so that no lookup stops too early.
+  *
+  * Returns: Nothing.
+  */
+ static void index_remove(graph *g, node *n){
+   unsigned int mask = g->index_size - 1;
+   unsigned int hole = n->hash & mask;
+   while(g->index[hole] != n){
+     hole = (hole + 1) & mask;
+   };
+   g->index[hole] = NULL;
+
+   unsigned int slot = (hole + 1) & mask;
+   while(g->index[slot] != NULL){
+     // distances from the home slot, modulo the size of the index
+     unsigned int home = g->index[slot]->hash & mask;
+     if(((slot - home) & mask) >= ((slot - hole) & mask)){
+       g->index[hole] = g->index[slot];
+       g->index[slot] = NULL;
+       hole = slot;
+     };
+     slot = (slot + 1) & mask;
+   };
+   g->index_count--;
+ };
+
+ /**
+  * unlink_edge() - Remove an edge from the out-list of its source and
+  * the in-list of its target, and free it.
+  * @g: Graph to modify.
+  * @e: Edge to remove.
+  *
+  * Returns: Nothing.
+  */
+ static void unlink_edge(graph *g, edge *e){
+   if(e->out_prev != NULL){
+     e->out_prev->out_next = e->out_next;
+   }else{
+     e->from->out = e->out_next;
+   };
+   if(e->out_next != NULL){
+     e->out_next->out_prev = e->out_prev;
+   };
+   if(e->in_prev != NULL){
+     e->in_prev->in_next = e->in_next;
+   }else{
+     e->to->in = e->in_next;
+   };
+   if(e->in_next != NULL){
+     e->in_next->in_prev = e->in_prev;
+   };
+
+   e->from->out_degree--;
+   e->to->in_degree--;
+   g->edge_count--;
+   arena_free(g->arena, e, sizeof(*e));
+ };
+
+
+ /**
+  * find_root() - Find the root of a node in the union-find forest and
+  * point every node on the way directly to it (path compression).
+  * @n: Node to find the root of.
+  *
+  * Returns: The root of the tree of n.
+  */
+ static node *find_root(node *n){
+   node *root = n;
+   while(root->parent != root){
+     root = root->parent;
+   };
+   while(n != root){
+     node *next = n->parent;
+     n->parent = root;
+     n = next;
+   };
+   return root;
+ };
+
+ /**
+  * union_nodes() - Merge the union-find trees of two nodes, hanging the
+  * tree of lower rank below the other (union by rank).
+  * @n1: Node of the first tree.
+  * @n2: Node of the second tree.
+  *
+  * Returns: Nothing.
+  */
+ static void union_nodes(node *n1, node *n2){
+   node *r1 = find_root(n1);
+   node *r2 = find_root(n2);
+   if(r1 == r2){
+     return;
+   };
+   if(r1->rank < r2->rank){
+     r1->parent = r2;
+   }else if(r1->rank > r2->rank){
+     r2->parent = r1;
+   }else{
+     r2->parent = r1;
+     r1->rank++;
+   };
+ };
+
+
+ /**
+  * rebuild_components() - Rebuild the union-find forest of an undirected
+  * graph from its edges.
+  * @g: Graph to modify.
+  *
+  * Returns: Nothing.
+  */
+ static void rebuild_components(graph *g){
+   for(int i = 0; i < g->node_count; i++){
+     if(g->nodes[i] != NULL){
+       g->nodes[i]->parent = g->nodes[i];
+       g->nodes[i]->rank = 0;
+       g->nodes[i]->linked = false;
+     };
+   };
+   for(int i = 0; i < g->node_count; i++){
+     if(g->nodes[i] == NULL){
+       continue;
+     };
+     for(edge *e = g->nodes[i]->out; e != NULL; e = e->out_next){
+       union_nodes(e->from, e->to);
+       e->from->linked = true;
+       e->to->linked = true;
+     };
+   };
+   g->components_stale = false;
+ };
+
+
+ /**
+  * new_id() - Take the next node id, growing the array of nodes if
+  * needed.
+  * @g: Graph to modify.
+  *
+  * Returns: The new id, its slot holds NULL.
+  */
+ static int new_id(graph *g){
+   int id = g->node_count++;
+   if(id == g->nodes_size){
+     g->nodes_size *= 2;
+     g->nodes = realloc(g->nodes, g->nodes_size * sizeof(*g->nodes));
+   };
+   g->nodes[id] = NULL;
+   return id;
+ };
+
+ /**
+  * add_node() - Create a node whose name is not in the graph.
+  * @g: Graph to modify.
+  * @s: Node name, need not be null-terminated but must not contain '\0'.
+  * @len: Length of the name.
+  * @hash: Hash value of the name.
+  *
+  * Returns: The new node.
+  */
+ static node *add_node(graph *g, const char *s, size_t len,
+ unsigned int hash){
+   // create new node with its name interned in the names arena
+   node *new_node = arena_alloc(g->arena, sizeof(*new_node));
+   char *node_name = arena_alloc(g->names, len + 1);
+   // set links and insert in list of nodes
+   memcpy(node_name, s, len);
+   node_name[len] = '\0';
+   new_node->name = node_name;
+   new_node->seen = 0;
+   new_node->hash = hash;
+   new_node->id = new_id(g);
+   new_node->parent = new_node;
+   g->nodes[new_node->id] = new_node;
+
+   // keep the index at most half full
+   if(2 * (g->index_count + 1) > g->index_size){
+     index_grow(g);
+   };
+   index_insert(g->index, g->index_size, new_node);
+   g->index_count++;
+   g->generation++;
+
+   return new_node;
+ };
+
+ /**
+  * checksum() - Hash an array of words (FNV-1a).
+  * @words: Words to hash.
+  * @count: Number of words.
+  * @hash: Hash of the words before, 2166136261u to start.
+  *
+  * Returns: The hash value.
+  */
+ static unsigned int checksum(const unsigned int *words, size_t count,
+ unsigned int hash){
+   for(size_t i = 0; i < count; i++){
+     hash = (hash ^ words[i]) * 16777619u;
+   };
+   return hash;
+ };
+
+ /**
+  * fill_in_edges() - Build the in-edges of a CSR snapshot from its
+  *                   out-edges.
+  * @c: Snapshot with offsets and targets set, in_offsets all 0 and room
+  * for num_edges sources.
+  *
+  * Returns: Nothing.
+  */
+ static void fill_in_edges(csr_graph *c){
+   for(int k = 0; k < c->num_edges; k++){
+     c->in_offsets[c->targets[k] + 1]++;
+   };
+   for(int i = 0; i < c->num_nodes; i++){
+     c->in_offsets[i + 1] += c->in_offsets[i];
+   };
+   int *fill = malloc((c->num_nodes + 1) * sizeof(*fill));
+   memcpy(fill, c->in_offsets, c->num_nodes * sizeof(*fill));
+   for(int i = 0; i < c->num_nodes; i++){
+     for(int k = c->offsets[i]; k < c->offsets[i + 1]; k++){
+       c->sources[fill[c->targets[k]]++] = i;
+     };
+   };
+   free(fill);
  };
 
 
@@ -40,14 +437,8 @@ int num_of_nodes;
   *
   */
  bool nodes_are_equal(const node *n1,const node *n2){
-   char *n1_copy = n1->name;
-   char *n2_copy = n2->name;
-   if(strcmp(n1_copy, n2_copy)==0){
-
-     return true;
-   };
-
-   return false;
+   // names are interned, so there is exactly one node per name
+   return n1 == n2;
  };
 
 
@@ -61,9 +452,33 @@ int num_of_nodes;
    */
   graph *graph_empty(int max_nodes){
     graph *g = calloc(1, sizeof(*g));
-    g->nodes = dlist_empty(NULL);
+    g->arena = arena_empty(0);
+    g->names = arena_empty(0);
     num_of_nodes = max_nodes;
+    g->epoch = 1;
+
+    // size the index so that max_nodes fit without rehashing, the bound is
+    // taken in long and the size stops doubling before it overflows an int
+    g->index_size = 16;
+    while(g->index_size < 2L * max_nodes && g->index_size <= INT_MAX / 2){
+      g->index_size *= 2;
+    };
+    g->index = calloc(g->index_size, sizeof(*g->index));
+    g->nodes_size = max_nodes > 16 ? max_nodes : 16;
+    g->nodes = calloc(g->nodes_size, sizeof(*g->nodes));
+
+    return g;
+  };
 
+  /**
+   * graph_empty_undirected() - Create an empty undirected graph.
+   * @max_nodes: The maximum number of nodes the graph can hold.
+   *
+   * Returns: A pointer to the new graph.
+   */
+  graph *graph_empty_undirected(int max_nodes){
+    graph *g = graph_empty(max_nodes);
+    g->undirected = true;
     return g;
   };
 
@@ -74,7 +489,7 @@ int num_of_nodes;
    * Returns: True if graph is empty, otherwise false.
    */
   bool graph_is_empty(const graph *g){
-    return dlist_is_empty(g->nodes);
+    return g->index_count == 0;
   };
 
 
@@ -84,23 +499,33 @@ int num_of_nodes;
    * @s: Node name.
    *
    * Creates a new node with a copy of the given name and puts it into
-   * the graph.
+   * the graph. If a node with the name already exists, the graph is
+   * not changed.
    *
    * Returns: The modified graph.
    */
   graph *graph_insert_node(graph *g, const char *s){
+    graph_intern_node(g, s, strlen(s));
+    return g;
+  };
 
-    // create new node
-    node *new_node = malloc(sizeof(*new_node));
-    char *node_name = (char*)malloc(sizeof(strlen(s))+1);
-    // set links and insert in list of nodes
-    strcpy(node_name, s);
-    new_node->name = node_name;
-    new_node->neighbours = dlist_empty(NULL);
-    new_node->seen = false;
-    dlist_insert(g->nodes, new_node, dlist_first(g->nodes));
+  /**
+   * graph_intern_node() - Return the node with a given name, inserting it
+   * if it is not in the graph.
+   * @g: Graph to manipulate.
+   * @s: Node name, need not be null-terminated but must not contain '\0'.
+   * @len: Length of the name.
+   *
+   * Returns: The node with the name.
+   */
+  node *graph_intern_node(graph *g, const char *s, size_t len){
+    // names are unique, return the node if the name is already in the graph
+    node *found = graph_find_node_n(g, s, len);
+    if(found != NULL){
+      return found;
+    };
 
-    return g;
+    return add_node(g, s, len, hash_name(s, len));
   };
 
 
@@ -112,29 +537,33 @@ int num_of_nodes;
    * Returns: A pointer to the found node, or NULL.
    */
   node *graph_find_node(const graph *g, const char *s){
+    return graph_find_node_n(g, s, strlen(s));
+  };
 
+  /**
+   * graph_find_node_n() - Find a node by a name that is given as a slice.
+   * @g: Graph to inspect.
+   * @s: Node name, need not be null-terminated but must not contain '\0'.
+   * @len: Length of the name.
+   *
+   * Returns: A pointer to the found node, or NULL.
+   */
+  node *graph_find_node_n(const graph *g, const char *s, size_t len){
+    unsigned int hash = hash_name(s, len);
+    unsigned int mask = g->index_size - 1;
+    unsigned int slot = hash & mask;
 
-    if(dlist_is_empty(g->nodes)){
-      return NULL;
-    };
-
-    // iterate through list of nodes and return if match exists
-    dlist_pos pos = dlist_first(g->nodes);
-    while(!dlist_is_end(g->nodes, pos)){
-
-      // compare node name to char array, if true -> return pointer to the
-      // found node
-      node *inspected = dlist_inspect(g->nodes, pos);
-      if(strncmp(inspected->name, s, strlen(s)+1)==0){
+    // follow the probe sequence until the name or an empty slot is found
+    while(g->index[slot] != NULL){
+      node *inspected = g->index[slot];
+      if(inspected->hash == hash && strncmp(inspected->name, s, len) == 0
+      && inspected->name[len] == '\0'){
         return inspected;
       };
-
-      pos = dlist_next(g->nodes, pos);
-
+      slot = (slot + 1) & mask;
     };
 
     return NULL;
-
   };
 
   /**
@@ -149,19 +578,604 @@ int num_of_nodes;
    */
 
   graph *graph_insert_edge(graph *g, node *n1, node *n2){
-    node *dest;
-    // iterate through nodes in graph and copy pointer to n2
-    dlist_pos  pos = dlist_first(g->nodes);
-    while(!dlist_is_end(g->nodes,pos)){
-      node* inspect = dlist_inspect(g->nodes, pos);
-      if(nodes_are_equal(n2, inspect)){
-        dest = inspect;
-      }
-      pos = dlist_next(g->nodes, pos);
-    }
-    // insert pointer to n2 in n1's list of neighbours
-    dlist_insert(n1->neighbours, dest, dlist_first(n1->neighbours));
+    return graph_insert_weighted_edge(g, n1, n2, 1);
+  };
+
+  /**
+   * graph_insert_weighted_edge() - Insert an edge with a weight into the
+   * graph.
+   * @g: Graph to manipulate.
+   * @n1: Source node (pointer) for the edge.
+   * @n2: Destination node (pointer) for the edge.
+   * @weight: Weight of the edge, e.g. a distance, at least 0.
+   *
+   * NOTE: Undefined unless both nodes are already in the graph.
+   *
+   * Returns: The modified graph.
+   */
+  graph *graph_insert_weighted_edge(graph *g, node *n1, node *n2,
+  int weight){
+    // put the edge first in n1's out-list and in n2's in-list
+    edge *e = arena_alloc(g->arena, sizeof(*e));
+    e->from = n1;
+    e->to = n2;
+    e->weight = weight;
+    e->out_next = n1->out;
+    if(n1->out != NULL){
+      n1->out->out_prev = e;
+    };
+    n1->out = e;
+    e->in_next = n2->in;
+    if(n2->in != NULL){
+      n2->in->in_prev = e;
+    };
+    n2->in = e;
+    n1->out_degree++;
+    n2->in_degree++;
+    g->edge_count++;
+    g->generation++;
+
+    // keep the connected components of an undirected graph up to date
+    if(g->undirected){
+      union_nodes(n1, n2);
+      n1->linked = true;
+      n2->linked = true;
+    };
+
+    return g;
+  };
+
+  /**
+   * graph_nodes_connected() - Check if two nodes of an undirected graph
+   * are connected.
+   * @g: Graph storing the nodes.
+   * @n1: First node.
+   * @n2: Second node.
+   *
+   * Returns: True if there is a path of at least one edge between the
+   * nodes, otherwise false.
+   */
+  bool graph_nodes_connected(graph *g, node *n1, node *n2){
+    if(g->components_stale){
+      rebuild_components(g);
+    };
+    if(n1 == n2){
+      return n1->linked;
+    };
+    return find_root(n1) == find_root(n2);
+  };
+
+  /**
+   * graph_delete_node() - Remove a node from the graph.
+   * @g: Graph to manipulate.
+   * @n: Node to remove from the graph.
+   *
+   * Removes the node together with all edges to and from it, in time
+   * proportional to its degree. The id of the node is not reused.
+   *
+   * Returns: The modified graph.
+   *
+   * NOTE: Undefined if the node is not in the graph.
+   */
+  graph *graph_delete_node(graph *g, node *n){
+    // a self loop is in both lists, so it is gone before the in-edges
+    while(n->out != NULL){
+      unlink_edge(g, n->out);
+    };
+    while(n->in != NULL){
+      unlink_edge(g, n->in);
+    };
+
+    index_remove(g, n);
+    g->nodes[n->id] = NULL;
+    if(g->undirected){
+      g->components_stale = true;
+    };
+    g->generation++;
+    arena_free(g->names, n->name, strlen(n->name) + 1);
+    arena_free(g->arena, n, sizeof(*n));
+
+    return g;
+  };
+
+  /**
+   * graph_delete_edge() - Remove an edge from the graph.
+   * @g: Graph to manipulate.
+   * @n1: Source node (pointer) for the edge.
+   * @n2: Destination node (pointer) for the edge.
+   *
+   * Finds the edge in the shorter of the out-list of n1 and the in-list
+   * of n2, and removes one copy of it.
+   *
+   * Returns: The modified graph.
+   *
+   * NOTE: Undefined if the edge is not in the graph.
+   */
+  graph *graph_delete_edge(graph *g, node *n1, node *n2){
+    edge *e;
+    if(n1->out_degree <= n2->in_degree){
+      e = n1->out;
+      while(e->to != n2){
+        e = e->out_next;
+      };
+    }else{
+      e = n2->in;
+      while(e->from != n1){
+        e = e->in_next;
+      };
+    };
+
+    unlink_edge(g, e);
+    if(g->undirected){
+      g->components_stale = true;
+    };
+    g->generation++;
+
+    return g;
+  };
+
+  /**
+   * graph_cache_results() - Attach a cache of reachability answers to the
+   * graph.
+   * @g: Graph to manipulate.
+   * @capacity: Number of answers to keep, 0 removes the cache.
+   *
+   * Returns: The modified graph.
+   */
+  graph *graph_cache_results(graph *g, int capacity){
+    if(g->cache != NULL){
+      reach_cache_kill(g->cache);
+      g->cache = NULL;
+    };
+    if(capacity > 0){
+      g->cache = reach_cache_empty(capacity);
+    };
+    return g;
+  };
+
+  /**
+   * graph_cache_lookup() - Look up a cached reachability answer.
+   * @g: Graph storing the nodes.
+   * @n1: Origin node.
+   * @n2: Destination node.
+   * @reachable: Set to the cached answer on a hit.
+   *
+   * Returns: True on a hit, false if there is no cache or no answer from
+   * the current version of the graph.
+   */
+  bool graph_cache_lookup(graph *g, const node *n1, const node *n2,
+  bool *reachable){
+    if(g->cache == NULL){
+      return false;
+    };
+    return reach_cache_lookup(g->cache, n1->id, n2->id, g->generation,
+    reachable);
+  };
+
+  /**
+   * graph_cache_store() - Cache a reachability answer.
+   * @g: Graph storing the nodes.
+   * @n1: Origin node.
+   * @n2: Destination node.
+   * @reachable: Answer for the current version of the graph.
+   *
+   * Returns: The modified graph.
+   */
+  graph *graph_cache_store(graph *g, const node *n1, const node *n2,
+  bool reachable){
+    if(g->cache != NULL){
+      reach_cache_store(g->cache, n1->id, n2->id, g->generation, reachable);
+    };
+    return g;
+  };
+
+  /**
+   * graph_cache_counts() - Return the hit and miss counts of the cache.
+   * @g: Graph to inspect.
+   * @hits: Set to the number of lookups that found an answer.
+   * @misses: Set to the number of lookups that did not.
+   *
+   * Returns: Nothing.
+   */
+  void graph_cache_counts(const graph *g, long *hits, long *misses){
+    *hits = 0;
+    *misses = 0;
+    if(g->cache != NULL){
+      reach_cache_counts(g->cache, hits, misses);
+    };
+  };
+
+  /**
+   * graph_collect_stats() - Attach statistics of reachability queries to
+   * the graph.
+   * @g: Graph to manipulate.
+   * @num_shards: Number of threads that record at the same time, 0
+   * removes the statistics.
+   *
+   * Returns: The modified graph.
+   */
+  graph *graph_collect_stats(graph *g, int num_shards){
+    if(g->stats != NULL){
+      query_stats_kill(g->stats);
+      g->stats = NULL;
+    };
+    if(num_shards > 0){
+      g->stats = query_stats_empty(num_shards);
+    };
+    return g;
+  };
+
+  /**
+   * graph_record_query() - Record what a reachability query cost.
+   * @g: Graph storing the nodes.
+   * @shard: Shard of the calling thread.
+   * @n1: Origin node.
+   * @n2: Destination node.
+   * @q: Counters of the query.
+   *
+   * Returns: The graph.
+   */
+  graph *graph_record_query(graph *g, int shard, const node *n1,
+  const node *n2, const query_counters *q){
+    if(g->stats != NULL){
+      query_stats_record(g->stats, shard, n1->id, n2->id, q);
+    };
+    return g;
+  };
+
+  /**
+   * graph_stats() - Summarize the recorded reachability queries.
+   * @g: Graph to inspect.
+   * @sum: Filled in with the summary.
+   *
+   * Returns: True if the graph has statistics, otherwise false.
+   */
+  bool graph_stats(const graph *g, query_summary *sum){
+    if(g->stats == NULL){
+      return false;
+    };
+    query_stats_summary(g->stats, sum);
+    return true;
+  };
+
+  /**
+   * graph_node_id() - Return the dense id of a node.
+   * @g: Graph storing the node.
+   * @n: Node in the graph.
+   *
+   * Nodes are numbered 0, 1, ... in insertion order, until
+   * graph_reorder() renumbers them. The ids of deleted nodes are not
+   * reused.
+   *
+   * Returns: The id of the node.
+   */
+  int graph_node_id(const graph *g, const node *n){
+    return n->id;
+  };
+
+  /**
+   * graph_node_name() - Return the name of a node.
+   * @g: Graph storing the node.
+   * @n: Node in the graph.
+   *
+   * Returns: The name of the node, owned by the graph.
+   */
+  const char *graph_node_name(const graph *g, const node *n){
+    return n->name;
+  };
+
+  /**
+   * graph_node_by_id() - Return the node with a given id.
+   * @g: Graph to inspect.
+   * @id: Node id.
+   *
+   * Returns: The node with the id, or NULL if the id is out of range or
+   * its node has been deleted.
+   */
+  node *graph_node_by_id(const graph *g, int id){
+    if(id < 0 || id >= g->node_count){
+      return NULL;
+    };
+    return g->nodes[id];
+  };
+
+  /**
+   * graph_node_count() - Return the number of node ids in use.
+   * @g: Graph to inspect.
+   *
+   * Returns: One more than the largest node id, or 0 for an empty graph.
+   */
+  int graph_node_count(const graph *g){
+    return g->node_count;
+  };
+
+  /**
+   * graph_freeze() - Build an immutable CSR snapshot of the graph.
+   * @g: Graph to inspect.
+   *
+   * Returns: A pointer to the new snapshot. Note: The snapshot must be
+   * csr_kill()-ed after use.
+   */
+  csr_graph *graph_freeze(const graph *g){
+    csr_graph *c = calloc(1, sizeof(*c));
+    c->num_nodes = g->node_count;
+    c->num_edges = g->edge_count;
+    c->offsets = calloc(c->num_nodes + 1, sizeof(*c->offsets));
+    c->targets = malloc((c->num_edges + 1) * sizeof(*c->targets));
+    c->weights = malloc((c->num_edges + 1) * sizeof(*c->weights));
+    c->in_offsets = calloc(c->num_nodes + 1, sizeof(*c->in_offsets));
+    c->sources = malloc((c->num_edges + 1) * sizeof(*c->sources));
+    c->nodes = malloc((c->num_nodes + 1) * sizeof(*c->nodes));
+
+    // the out-degree of each node goes to offsets[id+1] for now, deleted
+    // nodes keep a NULL slot without edges
+    for(int i = 0; i < c->num_nodes; i++){
+      c->nodes[i] = g->nodes[i];
+      if(g->nodes[i] != NULL){
+        c->offsets[i + 1] = g->nodes[i]->out_degree;
+      };
+    };
+
+    // prefix sum turns the degrees into offsets
+    for(int i = 0; i < c->num_nodes; i++){
+      c->offsets[i + 1] += c->offsets[i];
+    };
+
+    // copy the neighbour ids of each node into its slice of targets
+    for(int i = 0; i < c->num_nodes; i++){
+      if(g->nodes[i] == NULL){
+        continue;
+      };
+      int k = c->offsets[i];
+      for(edge *e = g->nodes[i]->out; e != NULL; e = e->out_next){
+        c->weights[k] = e->weight;
+        c->targets[k++] = e->to->id;
+      };
+    };
+
+    // the reverse edges are built the same way from the in-degrees
+    fill_in_edges(c);
+    return c;
+  };
+
+  /**
+   * graph_reorder() - Renumber the nodes of the graph for locality.
+   * @g: Graph to manipulate.
+   * @order: Order to number the nodes in.
+   *
+   * Returns: The modified graph.
+   */
+  graph *graph_reorder(graph *g, graph_order order){
+    csr_graph *c = graph_freeze(g);
+    int count;
+    int *ids = reorder_nodes(c, order, &count);
+
+    // the array keeps its size, the live nodes are at most that many
+    node **nodes = calloc(g->nodes_size, sizeof(*nodes));
+    for(int i = 0; i < count; i++){
+      nodes[i] = c->nodes[ids[i]];
+      nodes[i]->id = i;
+    };
+    free(g->nodes);
+    g->nodes = nodes;
+    g->node_count = count;
+    // cached answers are keyed by the old ids
+    g->generation++;
 
+    free(ids);
+    csr_kill(c);
+    return g;
+  };
+
+  /**
+   * graph_save_binary() - Write the graph to a binary snapshot file.
+   * @g: Graph to save.
+   * @path: Name of the file to write.
+   *
+   * Returns: True if the file was written, otherwise false.
+   */
+  bool graph_save_binary(const graph *g, const char *path){
+    int n = g->node_count;
+    int m = g->edge_count;
+    int *offsets = calloc(n + 1, sizeof(*offsets));
+    int *targets = malloc((m + 1) * sizeof(*targets));
+    int *weights = malloc((m + 1) * sizeof(*weights));
+    int *name_offsets = calloc(n + 1, sizeof(*name_offsets));
+    unsigned int *hashes = calloc(n + 1, sizeof(*hashes));
+
+    // the edges in out-list order, as graph_freeze() lays them out
+    for(int i = 0; i < n; i++){
+      offsets[i + 1] = offsets[i];
+      name_offsets[i + 1] = name_offsets[i];
+      node *inspect = g->nodes[i];
+      if(inspect == NULL){
+        continue;
+      };
+      for(edge *e = inspect->out; e != NULL; e = e->out_next){
+        weights[offsets[i + 1]] = e->weight;
+        targets[offsets[i + 1]++] = e->to->id;
+      };
+      name_offsets[i + 1] += strlen(inspect->name) + 1;
+      hashes[i] = inspect->hash;
+    };
+
+    // the names are padded with '\0' to whole words
+    int names_size = (name_offsets[n] + 3) & ~3;
+    char *names = calloc(names_size + 4, 1);
+    for(int i = 0; i < n; i++){
+      if(g->nodes[i] != NULL){
+        strcpy(names + name_offsets[i], g->nodes[i]->name);
+      };
+    };
+
+    snapshot_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.num_nodes = n;
+    header.num_edges = m;
+    header.names_size = names_size;
+    unsigned int hash = 2166136261u;
+    hash = checksum((unsigned int *)offsets, n + 1, hash);
+    hash = checksum((unsigned int *)targets, m, hash);
+    hash = checksum((unsigned int *)weights, m, hash);
+    hash = checksum((unsigned int *)name_offsets, n + 1, hash);
+    hash = checksum(hashes, n, hash);
+    header.checksum = checksum((unsigned int *)names, names_size / 4, hash);
+
+    FILE *f = fopen(path, "wb");
+    bool ok = f != NULL
+    && fwrite(&header, sizeof(header), 1, f) == 1
+    && fwrite(offsets, sizeof(int), n + 1, f) == (size_t)n + 1
+    && fwrite(targets, sizeof(int), m, f) == (size_t)m
+    && fwrite(weights, sizeof(int), m, f) == (size_t)m
+    && fwrite(name_offsets, sizeof(int), n + 1, f) == (size_t)n + 1
+    && fwrite(hashes, sizeof(int), n, f) == (size_t)n
+    && fwrite(names, 1, names_size, f) == (size_t)names_size;
+    if(f != NULL && fclose(f) != 0){
+      ok = false;
+    };
+    if(f != NULL && !ok){
+      remove(path);
+    };
+
+    free(offsets);
+    free(targets);
+    free(weights);
+    free(name_offsets);
+    free(hashes);
+    free(names);
+    return ok;
+  };
+
+  /**
+   * graph_load_binary() - Build a graph from a binary snapshot file.
+   * @path: Name of the file written by graph_save_binary().
+   * @undirected: If true, the graph is created by graph_empty_undirected().
+   * @frozen: If not NULL, set to a CSR snapshot copied from the file, and
+   * the graph only gets the nodes.
+   *
+   * Returns: The new graph, or NULL if the file could not be read or is
+   * not an intact snapshot.
+   */
+  graph *graph_load_binary(const char *path, bool undirected,
+  csr_graph **frozen){
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+      return NULL;
+    };
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(snapshot_header)){
+      close(fd);
+      return NULL;
+    };
+    size_t size = st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED){
+      return NULL;
+    };
+
+    // the header must match the size of the file before anything else is
+    // looked at
+    const snapshot_header *header = data;
+    int n = header->num_nodes;
+    int m = header->num_edges;
+    size_t words = (size - sizeof(*header)) / 4;
+    if(memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+    || header->version != SNAPSHOT_VERSION || n < 0 || m < 0
+    || header->names_size < 0 || header->names_size % 4 != 0
+    || (size - sizeof(*header)) % 4 != 0
+    || words != 3 * (size_t)n + 2 + 2 * (size_t)m + header->names_size / 4){
+      munmap(data, size);
+      return NULL;
+    };
+    const int *offsets = (const int *)(header + 1);
+    const int *targets = offsets + n + 1;
+    const int *weights = targets + m;
+    const int *name_offsets = weights + m;
+    const unsigned int *hashes = (const unsigned int *)(name_offsets + n + 1);
+    const char *names = (const char *)(hashes + n);
+    if(checksum((const unsigned int *)offsets, words, 2166136261u)
+    != header->checksum){
+      munmap(data, size);
+      return NULL;
+    };
+
+    graph *g = undirected ? graph_empty_undirected(n) : graph_empty(n);
+    csr_graph *c = NULL;
+    if(frozen != NULL){
+      // the out-edges are the arrays of the file as they are
+      c = calloc(1, sizeof(*c));
+      c->num_nodes = n;
+      c->num_edges = m;
+      c->offsets = malloc((n + 1) * sizeof(*c->offsets));
+      c->targets = malloc((m + 1) * sizeof(*c->targets));
+      c->weights = malloc((m + 1) * sizeof(*c->weights));
+      c->in_offsets = calloc(n + 1, sizeof(*c->in_offsets));
+      c->sources = malloc((m + 1) * sizeof(*c->sources));
+      c->nodes = malloc((n + 1) * sizeof(*c->nodes));
+      memcpy(c->offsets, offsets, (n + 1) * sizeof(*c->offsets));
+      memcpy(c->targets, targets, m * sizeof(*c->targets));
+      memcpy(c->weights, weights, m * sizeof(*c->weights));
+    };
+    bool ok = offsets[0] == 0 && offsets[n] == m && name_offsets[0] == 0
+    && name_offsets[n] <= header->names_size;
+
+    // every name is hashed again and looked up, as the text loader does,
+    // so a stored hash that does not match its name, an empty name or a
+    // name given twice makes the file invalid
+    for(int i = 0; ok && i < n; i++){
+      int start = name_offsets[i];
+      int len = name_offsets[i + 1] - start;
+      if(len < 0 || offsets[i + 1] < offsets[i]){
+        ok = false;
+      }else if(len == 0){
+        new_id(g);
+      }else if(len == 1 || names[start + len - 1] != '\0'
+      || memchr(names + start, '\0', len - 1) != NULL){
+        ok = false;
+      }else{
+        unsigned int hash = hash_name(names + start, len - 1);
+        if(hash != hashes[i]
+        || graph_find_node_n(g, names + start, len - 1) != NULL){
+          ok = false;
+        }else{
+          add_node(g, names + start, len - 1, hash);
+        };
+      };
+    };
+
+    // each out-list is built back to front, so it keeps its order, and
+    // a snapshot only needs its edges checked
+    for(int i = 0; ok && i < n; i++){
+      for(int k = offsets[i + 1] - 1; k >= offsets[i]; k--){
+        int t = targets[k];
+        if(g->nodes[i] == NULL || t < 0 || t >= n || g->nodes[t] == NULL
+        || weights[k] < 0){
+          ok = false;
+          break;
+        };
+        if(c == NULL){
+          graph_insert_weighted_edge(g, g->nodes[i], g->nodes[t],
+          weights[k]);
+        };
+      };
+    };
+
+    munmap(data, size);
+    if(!ok){
+      if(c != NULL){
+        csr_kill(c);
+      };
+      graph_kill(g);
+      return NULL;
+    };
+    if(c != NULL){
+      memcpy(c->nodes, g->nodes, n * sizeof(*c->nodes));
+      fill_in_edges(c);
+      *frozen = c;
+    };
     return g;
   };
 
@@ -173,10 +1187,7 @@ int num_of_nodes;
    * Returns: The seen status for the node.
    */
   bool graph_node_is_seen(const graph *g, const node *n){
-    if(n->seen){
-      return true;
-    }
-    return false;
+    return n->seen == g->epoch;
   };
 
 
@@ -189,7 +1200,8 @@ int num_of_nodes;
    * Returns: The modified graph.
    */
   graph *graph_node_set_seen(graph *g, node *n, bool seen){
-    n->seen = seen;
+    // stamp 0 is never a valid epoch
+    n->seen = seen ? g->epoch : 0;
     return g;
   };
 
@@ -201,24 +1213,17 @@ int num_of_nodes;
    * Returns: The modified graph.
    */
   graph *graph_reset_seen(graph *g){
-    // iterate through nodes and set seen status to false (default)
-    dlist_pos node_pos = dlist_first(g->nodes);
-
-    while(!dlist_is_end(g->nodes, node_pos)){
-      node *inspected_node = dlist_inspect(g->nodes, node_pos);
-      inspected_node->seen = false;
+    // starting a new epoch makes every old stamp stale
+    g->epoch++;
 
-      //iterate through nodes neighbours and set seen status to false (default)
-      dlist_pos neighbour_pos = dlist_first(inspected_node->neighbours);
-      while (!dlist_is_end(inspected_node->neighbours, neighbour_pos)){
-        node *inspected_neighbour = dlist_inspect(inspected_node->neighbours,
-        neighbour_pos);
-        inspected_neighbour->seen = false;
-
-        neighbour_pos = dlist_next(inspected_node->neighbours, neighbour_pos);
+    // only when the epoch counter wraps around do the stamps need clearing
+    if(g->epoch == 0){
+      for(int i = 0; i < g->node_count; i++){
+        if(g->nodes[i] != NULL){
+          g->nodes[i]->seen = 0;
+        };
       };
-
-      node_pos = dlist_next(g->nodes, node_pos);
+      g->epoch = 1;
     };
     return g;
   };
@@ -232,20 +1237,83 @@ int num_of_nodes;
    * dlist_kill()-ed after use.
    */
   dlist *graph_neighbours(const graph *g,const node *n){
-    dlist *neighbours;
-
-    // iterate through nodes in graph and get list of neighbours
-    dlist_pos pos = dlist_first(g->nodes);
-    while (!dlist_is_end(g->nodes,pos)) {
-      node *inspected_node = dlist_inspect(g->nodes, pos);
-      if(nodes_are_equal(n,inspected_node)){
-        neighbours = inspected_node->neighbours;
-      }
-      pos = dlist_next(g->nodes, pos);
-    }
-
+    // copy the targets of the out-edges, most recently inserted first
+    dlist *neighbours = dlist_empty(NULL);
+    dlist_pos pos = dlist_first(neighbours);
+    for(edge *e = n->out; e != NULL; e = e->out_next){
+      pos = dlist_next(neighbours, dlist_insert(neighbours, e->to, pos));
+    };
     return neighbours;
+  };
+
+  /**
+   * graph_first_edge() - Return the first out-edge of a node.
+   * @g: Graph to inspect.
+   * @n: Node to get the out-edges of.
+   *
+   * Returns: The first out-edge of n, or NULL if n has none.
+   */
+  edge *graph_first_edge(const graph *g, const node *n){
+    return n->out;
+  };
+
+  /**
+   * graph_next_edge() - Return the next out-edge of the same node.
+   * @g: Graph to inspect.
+   * @e: Out-edge of a node.
+   *
+   * Returns: The out-edge after e, or NULL if e is the last one.
+   */
+  edge *graph_next_edge(const graph *g, const edge *e){
+    return e->out_next;
+  };
 
+  /**
+   * graph_edge_target() - Return the destination node of an edge.
+   * @g: Graph to inspect.
+   * @e: Edge in the graph.
+   *
+   * Returns: The destination node of e.
+   */
+  node *graph_edge_target(const graph *g, const edge *e){
+    return e->to;
+  };
+
+  /**
+   * graph_first_edge_by_id() - Return the first out-edge of a node given
+   *                            by its id.
+   * @g: Graph to inspect.
+   * @id: Id of the node to get the out-edges of.
+   *
+   * Returns: The first out-edge of the node, or NULL if it has none or
+   * has been deleted.
+   */
+  edge *graph_first_edge_by_id(const graph *g, int id){
+    node *n = graph_node_by_id(g, id);
+    return n != NULL ? n->out : NULL;
+  };
+
+  /**
+   * graph_edge_target_id() - Return the id of the destination node of an
+   *                          edge.
+   * @g: Graph to inspect.
+   * @e: Edge in the graph.
+   *
+   * Returns: The id of the destination node of e.
+   */
+  int graph_edge_target_id(const graph *g, const edge *e){
+    return e->to->id;
+  };
+
+  /**
+   * graph_edge_weight() - Return the weight of an edge.
+   * @g: Graph to inspect.
+   * @e: Edge in the graph.
+   *
+   * Returns: The weight of e.
+   */
+  int graph_edge_weight(const graph *g, const edge *e){
+    return e->weight;
   };
 
   /**
@@ -259,25 +1327,17 @@ int num_of_nodes;
   void graph_print(const graph *g){
 
   // iterate through nodes and print node name
-  dlist_pos pos = dlist_first(g->nodes);
-
-  while(!dlist_is_end(g->nodes, pos)){
-    node *inspect = dlist_inspect(g->nodes, pos);
+  for(int i = 0; i < g->node_count; i++){
+    node *inspect = g->nodes[i];
+    if(inspect == NULL){
+      continue;
+    };
 
     // iterate through nodes neighbours and print neighbour names
-    dlist_pos pos2 = dlist_first(inspect->neighbours);
-
-    while(!dlist_is_end(inspect->neighbours, pos2)){
-      node *inspect2 = dlist_inspect(inspect->neighbours, pos2);
-      printf("%s -> %s\n", inspect->name, inspect2->name);
-
-      pos2 = dlist_next(inspect->neighbours, pos2);
-
+    for(edge *e = inspect->out; e != NULL; e = e->out_next){
+      printf("%s -> %s\n", inspect->name, e->to->name);
     };
 
-
-    pos = dlist_next(g->nodes, pos);
-
   };
 
 };
@@ -291,21 +1351,17 @@ int num_of_nodes;
    * Returns: Nothing.
    */
   void graph_kill(graph *g){
-    // iterate through nodes in graph
-    dlist_pos pos1 = dlist_first(g->nodes);
-    while(!dlist_is_end(g->nodes, pos1)){
-      node *inspect1 = dlist_inspect(g->nodes, pos1);
-
-      // kill neighbour list and free node
-      dlist_kill(inspect1->neighbours);
-      free(inspect1->name);
-
-      free(inspect1);
-
-      pos1 = dlist_next(g->nodes, pos1);
+    // nodes, names and edges live in the arenas, kill them with the
+    // index and free graph
+    arena_kill(g->arena);
+    arena_kill(g->names);
+    free(g->index);
+    free(g->nodes);
+    if(g->cache != NULL){
+      reach_cache_kill(g->cache);
+    };
+    if(g->stats != NULL){
+      query_stats_kill(g->stats);
     };
-
-    // kill node list and free graph
-    dlist_kill(g->nodes);
     free(g);
   };
@@ -2,8 +2,10 @@
 #define __GRAPH_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "util.h"
 #include "dlist.h"
+#include "query_stats.h"
 
 /*
  * Declaration of a generic graph for the "Datastructures and
@@ -36,6 +38,19 @@
 typedef struct node node;
 typedef struct graph graph;
 
+// Anonymous declaration of an edge, its handle while it is in the graph.
+typedef struct edge edge;
+
+// Immutable CSR snapshot of a graph, see csr.h.
+typedef struct csr_graph csr_graph;
+
+// Node orders of graph_reorder().
+typedef enum {
+  GRAPH_ORDER_BFS,	// Breadth-first order, components one by one.
+  GRAPH_ORDER_RCM,	// Reverse Cuthill-McKee order.
+  GRAPH_ORDER_DEGREE	// Largest degree first.
+} graph_order;
+
 // =================== NODE COMPARISON FUNCTION ======================
 
 /**
@@ -43,6 +58,9 @@ typedef struct graph graph;
  * @n1: Pointer to node 1.
  * @n2: Pointer to node 2.
  *
+ * Node names are unique within a graph, so two nodes are equal exactly
+ * when they are the same node. Takes constant time.
+ *
  * Returns: true if the nodes are considered equal, otherwise false.
  *
  */
@@ -58,6 +76,20 @@ bool nodes_are_equal(const node *n1,const node *n2);
  */
 graph *graph_empty(int max_nodes);
 
+/**
+ * graph_empty_undirected() - Create an empty undirected graph.
+ * @max_nodes: The maximum number of nodes the graph can hold.
+ *
+ * An edge of an undirected graph is stored as given, so a route that can
+ * be taken both ways is inserted once in each direction. Besides the
+ * edges, the graph keeps a union-find structure of its connected
+ * components that is updated by graph_insert_edge() and answers
+ * graph_nodes_connected() without traversing the graph.
+ *
+ * Returns: A pointer to the new graph.
+ */
+graph *graph_empty_undirected(int max_nodes);
+
 /**
  * graph_is_empty() - Check if a graph is empty, i.e. has no nodes.
  * @g: Graph to check.
@@ -80,7 +112,8 @@ bool graph_has_edges(const graph *g);
  * @s: Node name.
  *
  * Creates a new node with a copy of the given name and puts it into
- * the graph.
+ * the graph. If a node with the name already exists, the graph is
+ * not changed.
  *
  * Returns: The modified graph.
  */
@@ -95,6 +128,31 @@ graph *graph_insert_node(graph *g, const char *s);
  */
 node *graph_find_node(const graph *g, const char *s);
 
+/**
+ * graph_intern_node() - Return the node with a given name, inserting it
+ *			 if it is not in the graph.
+ * @g: Graph to manipulate.
+ * @s: Node name, need not be null-terminated but must not contain '\0'.
+ * @len: Length of the name.
+ *
+ * Like graph_insert_node() followed by graph_find_node(), but with one
+ * lookup, and the name can be a slice of a larger buffer, e.g. of a
+ * memory-mapped file. The name is copied into the graph.
+ *
+ * Returns: The node with the name.
+ */
+node *graph_intern_node(graph *g, const char *s, size_t len);
+
+/**
+ * graph_find_node_n() - Find a node by a name that is given as a slice.
+ * @g: Graph to inspect.
+ * @s: Node name, need not be null-terminated but must not contain '\0'.
+ * @len: Length of the name.
+ *
+ * Returns: A pointer to the found node, or NULL.
+ */
+node *graph_find_node_n(const graph *g, const char *s, size_t len);
+
 /**
  * graph_node_is_seen() - Return the seen status for a node.
  * @g: Graph storing the node.
@@ -118,6 +176,8 @@ graph *graph_node_set_seen(graph *g, node *n, bool seen);
  * graph_reset_seen() - Reset the seen status on all nodes in the graph.
  * @g: Graph to modify.
  *
+ * Takes constant time, the nodes themselves are not visited.
+ *
  * Returns: The modified graph.
  */
 graph *graph_reset_seen(graph *g);
@@ -134,11 +194,251 @@ graph *graph_reset_seen(graph *g);
  */
 graph *graph_insert_edge(graph *g, node *n1, node *n2);
 
+/**
+ * graph_insert_weighted_edge() - Insert an edge with a weight into the
+ *				  graph.
+ * @g: Graph to manipulate.
+ * @n1: Source node (pointer) for the edge.
+ * @n2: Destination node (pointer) for the edge.
+ * @weight: Weight of the edge, e.g. a distance, at least 0.
+ *
+ * graph_insert_edge() inserts edges of weight 1.
+ *
+ * NOTE: Undefined unless both nodes are already in the graph.
+ *
+ * Returns: The modified graph.
+ */
+graph *graph_insert_weighted_edge(graph *g, node *n1, node *n2, int weight);
+
+/**
+ * graph_nodes_connected() - Check if two nodes of an undirected graph
+ *			     are connected.
+ * @g: Graph storing the nodes.
+ * @n1: First node.
+ * @n2: Second node.
+ *
+ * NOTE: Undefined unless the graph was created by
+ * graph_empty_undirected(). Takes nearly constant amortized time, the
+ * union-find trees are compressed on the way.
+ *
+ * Returns: True if there is a path of at least one edge between the
+ * nodes, ignoring edge directions, otherwise false.
+ */
+bool graph_nodes_connected(graph *g, node *n1, node *n2);
+
+/**
+ * graph_cache_results() - Attach a cache of reachability answers to the
+ *			   graph.
+ * @g: Graph to manipulate.
+ * @capacity: Number of answers to keep, 0 removes the cache.
+ *
+ * The cache keeps the most recently used answers for origin/destination
+ * pairs. Any insertion into the graph makes all cached answers stale.
+ * Any earlier cache of the graph is dropped.
+ *
+ * Returns: The modified graph.
+ */
+graph *graph_cache_results(graph *g, int capacity);
+
+/**
+ * graph_cache_lookup() - Look up a cached reachability answer.
+ * @g: Graph storing the nodes.
+ * @n1: Origin node.
+ * @n2: Destination node.
+ * @reachable: Set to the cached answer on a hit.
+ *
+ * Returns: True on a hit, false if the graph has no cache or no answer
+ * from the current version of the graph.
+ */
+bool graph_cache_lookup(graph *g, const node *n1, const node *n2,
+			bool *reachable);
+
+/**
+ * graph_cache_store() - Cache a reachability answer.
+ * @g: Graph storing the nodes.
+ * @n1: Origin node.
+ * @n2: Destination node.
+ * @reachable: Answer for the current version of the graph.
+ *
+ * Does nothing if the graph has no cache.
+ *
+ * Returns: The modified graph.
+ */
+graph *graph_cache_store(graph *g, const node *n1, const node *n2,
+			 bool reachable);
+
+/**
+ * graph_cache_counts() - Return the hit and miss counts of the cache.
+ * @g: Graph to inspect.
+ * @hits: Set to the number of lookups that found an answer.
+ * @misses: Set to the number of lookups that did not.
+ *
+ * Both counts are 0 if the graph has no cache.
+ *
+ * Returns: Nothing.
+ */
+void graph_cache_counts(const graph *g, long *hits, long *misses);
+
+/**
+ * graph_collect_stats() - Attach statistics of reachability queries to
+ *			   the graph.
+ * @g: Graph to manipulate.
+ * @num_shards: Number of threads that record queries at the same time,
+ * 0 removes the statistics.
+ *
+ * Any earlier statistics of the graph are dropped.
+ *
+ * Returns: The modified graph.
+ */
+graph *graph_collect_stats(graph *g, int num_shards);
+
+/**
+ * graph_record_query() - Record what a reachability query cost.
+ * @g: Graph storing the nodes.
+ * @shard: Shard of the calling thread, see query_stats_record().
+ * @n1: Origin node.
+ * @n2: Destination node.
+ * @q: Counters of the query.
+ *
+ * Does nothing if the graph has no statistics. Recording takes no lock.
+ *
+ * Returns: The graph.
+ */
+graph *graph_record_query(graph *g, int shard, const node *n1,
+			  const node *n2, const query_counters *q);
+
+/**
+ * graph_stats() - Summarize the recorded reachability queries.
+ * @g: Graph to inspect.
+ * @sum: Filled in with the summary. The slowest pair is given by node
+ * ids, see graph_node_id().
+ *
+ * Returns: True if the graph has statistics, otherwise false.
+ */
+bool graph_stats(const graph *g, query_summary *sum);
+
+/**
+ * graph_node_id() - Return the dense id of a node.
+ * @g: Graph storing the node.
+ * @n: Node in the graph.
+ *
+ * Nodes are numbered 0, 1, ... in insertion order, until
+ * graph_reorder() renumbers them. The ids of deleted nodes are not
+ * reused.
+ *
+ * Returns: The id of the node.
+ */
+int graph_node_id(const graph *g, const node *n);
+
+/**
+ * graph_node_name() - Return the name of a node.
+ * @g: Graph storing the node.
+ * @n: Node in the graph.
+ *
+ * Returns: The name of the node, owned by the graph.
+ */
+const char *graph_node_name(const graph *g, const node *n);
+
+/**
+ * graph_node_by_id() - Return the node with a given id.
+ * @g: Graph to inspect.
+ * @id: Node id.
+ *
+ * Returns: The node with the id, or NULL if the id is out of range or
+ * its node has been deleted.
+ */
+node *graph_node_by_id(const graph *g, int id);
+
+/**
+ * graph_node_count() - Return the number of node ids in use.
+ * @g: Graph to inspect.
+ *
+ * All ids are below this number, so an array of this many entries has
+ * a slot for every node, e.g. for a distance or parent per node. The
+ * ids of deleted nodes are counted until graph_reorder() drops them.
+ *
+ * Returns: One more than the largest node id, or 0 for an empty graph.
+ */
+int graph_node_count(const graph *g);
+
+/**
+ * graph_freeze() - Build an immutable CSR snapshot of the graph.
+ * @g: Graph to inspect.
+ *
+ * The snapshot uses the node ids of graph_node_id(). Later changes to
+ * the graph are not reflected in the snapshot.
+ *
+ * Returns: A pointer to the new snapshot. Note: The snapshot must be
+ * csr_kill()-ed after use.
+ */
+csr_graph *graph_freeze(const graph *g);
+
+/**
+ * graph_reorder() - Renumber the nodes of the graph for locality.
+ * @g: Graph to manipulate.
+ * @order: Order to number the nodes in.
+ *
+ * Gives the nodes the ids 0, 1, ... in the given order, following the
+ * edges in both directions, so that the snapshots of graph_freeze()
+ * keep nodes that are visited together close in memory. The ids of
+ * deleted nodes are dropped. Nodes, names and edges are unchanged, and
+ * graph_node_id() and graph_node_name() map between ids and names.
+ * Answers in the cache are dropped, and ids recorded earlier, e.g. by
+ * graph_record_query(), refer to the old numbering.
+ *
+ * Returns: The modified graph.
+ */
+graph *graph_reorder(graph *g, graph_order order);
+
+/**
+ * graph_save_binary() - Write the graph to a binary snapshot file.
+ * @g: Graph to save.
+ * @path: Name of the file to write.
+ *
+ * The snapshot holds a versioned header with a checksum, the CSR
+ * offsets, targets and weights of graph_freeze() and a table of the
+ * node names with their hashes. The arrays are stored as they are in
+ * memory, so a mapped file is read by copying them. Node ids, deleted
+ * ones included, and the order of the edges are kept.
+ *
+ * Returns: True if the file was written, otherwise false.
+ */
+bool graph_save_binary(const graph *g, const char *path);
+
+/**
+ * graph_load_binary() - Build a graph from a binary snapshot file.
+ * @path: Name of the file written by graph_save_binary().
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @frozen: If not NULL, set to a CSR snapshot of the file, and the graph
+ * only gets the nodes.
+ *
+ * The file is memory-mapped and the graph is built straight from its
+ * arrays, so nothing is parsed. Each name is hashed again and must match
+ * its stored hash, and no name may occur twice. The graph has the same
+ * node ids and edge order as the saved one.
+ *
+ * With frozen, the edges are not inserted into the graph. Instead the
+ * CSR arrays of the file are copied into a snapshot equal to the one
+ * graph_freeze() would make of the full graph, whose nodes are those of
+ * the returned graph. That graph can then be used to look up nodes, but
+ * not to follow edges.
+ *
+ * Returns: The new graph, or NULL if the file could not be read or is
+ * not an intact snapshot of this version. Note: The graph must be
+ * graph_kill()-ed after use, and *frozen csr_kill()-ed.
+ */
+graph *graph_load_binary(const char *path, bool undirected,
+			 csr_graph **frozen);
+
 /**
  * graph_delete_node() - Remove a node from the graph.
  * @g: Graph to manipulate.
  * @n: Node to remove from the graph.
  *
+ * Removes the node together with all edges to and from it, in time
+ * proportional to its degree. The id of the node is not reused, so the
+ * slot of the node in later snapshots has no edges and a NULL node.
+ *
  * Returns: The modified graph.
  *
  * NOTE: Undefined if the node is not in the graph.
@@ -151,6 +451,9 @@ graph *graph_delete_node(graph *g, node *n);
  * @n1: Source node (pointer) for the edge.
  * @n2: Destination node (pointer) for the edge.
  *
+ * Removes one copy of the edge, in time proportional to the smaller of
+ * the out-degree of n1 and the in-degree of n2.
+ *
  * Returns: The modified graph.
  *
  * NOTE: Undefined if the edge is not in the graph.
@@ -177,6 +480,71 @@ node *graph_choose_node(const graph *g);
  */
 dlist *graph_neighbours(const graph *g,const node *n);
 
+/**
+ * graph_first_edge() - Return the first out-edge of a node.
+ * @g: Graph to inspect.
+ * @n: Node to get the out-edges of.
+ *
+ * Together with graph_next_edge() and graph_edge_target(), the
+ * neighbours of a node can be visited without building a list. The
+ * out-edges come in the same order as the nodes of graph_neighbours().
+ *
+ * Returns: The first out-edge of n, or NULL if n has none.
+ */
+edge *graph_first_edge(const graph *g, const node *n);
+
+/**
+ * graph_next_edge() - Return the next out-edge of the same node.
+ * @g: Graph to inspect.
+ * @e: Out-edge of a node.
+ *
+ * Returns: The out-edge after e, or NULL if e is the last one.
+ */
+edge *graph_next_edge(const graph *g, const edge *e);
+
+/**
+ * graph_edge_target() - Return the destination node of an edge.
+ * @g: Graph to inspect.
+ * @e: Edge in the graph.
+ *
+ * Returns: The destination node of e.
+ */
+node *graph_edge_target(const graph *g, const edge *e);
+
+/**
+ * graph_first_edge_by_id() - Return the first out-edge of a node given
+ *			      by its id.
+ * @g: Graph to inspect.
+ * @id: Id of the node to get the out-edges of.
+ *
+ * Together with graph_next_edge() and graph_edge_target_id(), the
+ * neighbours of a node are visited by id, e.g. to update per-node state
+ * kept in arrays of graph_node_count() entries.
+ *
+ * Returns: The first out-edge of the node, or NULL if it has none or
+ * has been deleted.
+ */
+edge *graph_first_edge_by_id(const graph *g, int id);
+
+/**
+ * graph_edge_target_id() - Return the id of the destination node of an
+ *			    edge.
+ * @g: Graph to inspect.
+ * @e: Edge in the graph.
+ *
+ * Returns: The id of the destination node of e.
+ */
+int graph_edge_target_id(const graph *g, const edge *e);
+
+/**
+ * graph_edge_weight() - Return the weight of an edge.
+ * @g: Graph to inspect.
+ * @e: Edge in the graph.
+ *
+ * Returns: The weight of e.
+ */
+int graph_edge_weight(const graph *g, const edge *e);
+
 /**
  * graph_kill() - Destroy a given graph.
  * @g: Graph to destroy.
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hop_index.h"
+
+/*
+ * Implementation of a 2-hop reachability labeling of CSR snapshots.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * Label entries are the ranks of the landmark nodes, the position of the
+ * landmark in the order the pruned searches were run. Landmarks are
+ * added to the labels in rank order, so every label is sorted.
+ */
+struct hop_index {
+	int num_nodes;
+	bool *cyclic;		// Node has a path to itself.
+	int *out_offsets;	// Out-labels in CSR form.
+	int *out_labels;
+	int *in_offsets;	// In-labels in CSR form.
+	int *in_labels;
+};
+
+// Label of one node while the index is built.
+typedef struct {
+	int *items;
+	int count;
+	int capacity;
+} label;
+
+// Node and the key it is ordered by when choosing landmarks.
+typedef struct {
+	long key;
+	int node;
+} landmark;
+
+// Beginning of an index file, followed by the arrays of the index.
+typedef struct {
+	char magic[8];
+	int version;
+	int num_nodes;
+	int num_edges;
+	unsigned int fingerprint;
+	long out_entries;
+	long in_entries;
+} file_header;
+
+#define HOP_MAGIC "HOPINDEX"
+#define HOP_VERSION 1
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * label_add() - Append an entry to a label.
+ * @l: Label to append to.
+ * @rank: Entry to append.
+ *
+ * Returns: Nothing.
+ */
+static void label_add(label *l, int rank)
+{
+	if (l->count == l->capacity) {
+		l->capacity = l->capacity == 0 ? 4 : 2 * l->capacity;
+		l->items = realloc(l->items, l->capacity * sizeof(*l->items));
+	}
+	l->items[l->count++] = rank;
+}
+
+/**
+ * intersects() - See if two sorted arrays have a common entry.
+ * @a: First array.
+ * @na: Length of a.
+ * @b: Second array.
+ * @nb: Length of b.
+ *
+ * Returns: True if some entry is in both arrays, otherwise false.
+ */
+static bool intersects(const int *a, int na, const int *b, int nb)
+{
+	int i = 0;
+	int j = 0;
+	while (i < na && j < nb) {
+		if (a[i] == b[j]) {
+			return true;
+		}
+		if (a[i] < b[j]) {
+			i++;
+		} else {
+			j++;
+		}
+	}
+	return false;
+}
+
+/**
+ * compare_landmarks() - Order landmarks by decreasing key, then by node.
+ * @a: First landmark.
+ * @b: Second landmark.
+ *
+ * Returns: A negative, zero or positive value as for qsort().
+ */
+static int compare_landmarks(const void *a, const void *b)
+{
+	const landmark *x = a;
+	const landmark *y = b;
+	if (x->key != y->key) {
+		return x->key > y->key ? -1 : 1;
+	}
+	return x->node - y->node;
+}
+
+/**
+ * pruned_search() - Run the breadth-first search of one landmark and
+ *		     add it to the labels of the nodes it reaches.
+ * @offsets: Offsets of the edges to follow.
+ * @targets: Targets of the edges to follow.
+ * @root: Landmark to search from.
+ * @rank: Rank of the landmark.
+ * @from: Labels on the side of the landmark, out-labels when searching
+ *	  forward and in-labels when searching backward.
+ * @to: Labels to add the landmark to.
+ * @stamp: Search stamp of each node, holds values below epoch.
+ * @epoch: Stamp of the nodes seen by this search.
+ * @queue: Space for the search queue, one entry per node.
+ *
+ * A node is pruned, neither labelled nor expanded, if the labels of the
+ * earlier landmarks already connect it to the root.
+ *
+ * Returns: Nothing.
+ */
+static void pruned_search(const int *offsets, const int *targets, int root,
+			  int rank, label *from, label *to,
+			  unsigned int *stamp, unsigned int epoch,
+			  int *queue)
+{
+	const label *r = &from[root];
+	int head = 0;
+	int tail = 0;
+
+	queue[tail++] = root;
+	stamp[root] = epoch;
+	while (head < tail) {
+		int w = queue[head++];
+		if (intersects(r->items, r->count, to[w].items, to[w].count)) {
+			continue;
+		}
+		label_add(&to[w], rank);
+		for (int e = offsets[w]; e < offsets[w + 1]; e++) {
+			int x = targets[e];
+			if (stamp[x] != epoch) {
+				stamp[x] = epoch;
+				queue[tail++] = x;
+			}
+		}
+	}
+}
+
+/**
+ * compact() - Move the labels of all nodes into CSR form.
+ * @labels: Labels to move, their memory is freed.
+ * @n: Number of nodes.
+ * @offsets: Set to the offsets of the labels.
+ * @entries: Set to the entries of the labels.
+ *
+ * Returns: Nothing.
+ */
+static void compact(label *labels, int n, int **offsets, int **entries)
+{
+	*offsets = malloc((n + 1) * sizeof(**offsets));
+	(*offsets)[0] = 0;
+	for (int v = 0; v < n; v++) {
+		(*offsets)[v + 1] = (*offsets)[v] + labels[v].count;
+	}
+	*entries = malloc(((*offsets)[n] + 1) * sizeof(**entries));
+	for (int v = 0; v < n; v++) {
+		memcpy(*entries + (*offsets)[v], labels[v].items,
+		       labels[v].count * sizeof(**entries));
+		free(labels[v].items);
+	}
+	free(labels);
+}
+
+/**
+ * connected() - See if a node reaches another by a path of zero or more
+ *		 edges.
+ * @idx: Index to use.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: True if the labels connect src to dest, otherwise false.
+ */
+static bool connected(const hop_index *idx, int src, int dest)
+{
+	int out = idx->out_offsets[src];
+	int in = idx->in_offsets[dest];
+	return intersects(idx->out_labels + out, idx->out_offsets[src + 1] - out,
+			  idx->in_labels + in, idx->in_offsets[dest + 1] - in);
+}
+
+/**
+ * fingerprint() - Hash the edges of a snapshot.
+ * @c: Snapshot to hash.
+ *
+ * Returns: An FNV-1a hash of the offsets and targets of the snapshot.
+ */
+static unsigned int fingerprint(const csr_graph *c)
+{
+	unsigned int hash = 2166136261u;
+	for (int v = 0; v <= c->num_nodes; v++) {
+		hash = (hash ^ (unsigned int)c->offsets[v]) * 16777619u;
+	}
+	for (int e = 0; e < c->num_edges; e++) {
+		hash = (hash ^ (unsigned int)c->targets[e]) * 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * valid_labels() - See if labels read from a file can be queried safely.
+ * @offsets: Offsets of the labels, n+1 entries.
+ * @labels: Entries of the labels.
+ * @n: Number of nodes.
+ * @entries: Number of entries stated by the file header.
+ *
+ * Returns: True if the offsets run from 0 to entries without going
+ * back, and every label is strictly increasing in 0..n-1, otherwise
+ * false.
+ */
+static bool valid_labels(const int *offsets, const int *labels, int n,
+			 long entries)
+{
+	if (offsets[0] != 0 || offsets[n] != entries) {
+		return false;
+	}
+	for (int v = 0; v < n; v++) {
+		if (offsets[v + 1] < offsets[v]) {
+			return false;
+		}
+		int last = -1;
+		for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+			if (labels[k] <= last || labels[k] >= n) {
+				return false;
+			}
+			last = labels[k];
+		}
+	}
+	return true;
+}
+
+/**
+ * hop_index_build() - Build a 2-hop labeling of a snapshot.
+ * @c: Snapshot to index. The index does not refer to it after building.
+ *
+ * The landmarks are taken in order of decreasing (in-degree + 1) *
+ * (out-degree + 1), so that the hubs that lie on many paths come first
+ * and prune the searches of the rest.
+ *
+ * Returns: A pointer to the new index.
+ */
+hop_index *hop_index_build(const csr_graph *c)
+{
+	int n = c->num_nodes;
+	hop_index *idx = malloc(sizeof(*idx));
+	landmark *order = malloc((n + 1) * sizeof(*order));
+	label *out = calloc(n + 1, sizeof(*out));
+	label *in = calloc(n + 1, sizeof(*in));
+	unsigned int *stamp = calloc(n + 1, sizeof(*stamp));
+	int *queue = malloc((n + 1) * sizeof(*queue));
+	unsigned int epoch = 0;
+
+	idx->num_nodes = n;
+	for (int v = 0; v < n; v++) {
+		long out_degree = c->offsets[v + 1] - c->offsets[v];
+		long in_degree = c->in_offsets[v + 1] - c->in_offsets[v];
+		order[v].key = (out_degree + 1) * (in_degree + 1);
+		order[v].node = v;
+	}
+	qsort(order, n, sizeof(*order), compare_landmarks);
+
+	for (int rank = 0; rank < n; rank++) {
+		int v = order[rank].node;
+		pruned_search(c->offsets, c->targets, v, rank, out, in,
+			      stamp, ++epoch, queue);
+		pruned_search(c->in_offsets, c->sources, v, rank, in, out,
+			      stamp, ++epoch, queue);
+	}
+	compact(out, n, &idx->out_offsets, &idx->out_labels);
+	compact(in, n, &idx->in_offsets, &idx->in_labels);
+
+	// A node is on a cycle if one of its successors reaches it.
+	idx->cyclic = calloc(n + 1, sizeof(*idx->cyclic));
+	for (int v = 0; v < n; v++) {
+		for (int e = c->offsets[v]; e < c->offsets[v + 1]; e++) {
+			if (connected(idx, c->targets[e], v)) {
+				idx->cyclic[v] = true;
+				break;
+			}
+		}
+	}
+
+	free(order);
+	free(stamp);
+	free(queue);
+	return idx;
+}
+
+/**
+ * hop_index_query() - See if a path exists between two nodes.
+ * @idx: Index to use.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool hop_index_query(const hop_index *idx, int src, int dest)
+{
+	if (src == dest) {
+		return idx->cyclic[src];
+	}
+	return connected(idx, src, dest);
+}
+
+/**
+ * hop_index_stats() - Return the label sizes of an index.
+ * @idx: Index to inspect.
+ * @stats: Filled in with the label sizes.
+ *
+ * Returns: Nothing.
+ */
+void hop_index_stats(const hop_index *idx, hop_stats *stats)
+{
+	int n = idx->num_nodes;
+
+	stats->num_nodes = n;
+	stats->out_entries = idx->out_offsets[n];
+	stats->in_entries = idx->in_offsets[n];
+	stats->max_out = 0;
+	stats->max_in = 0;
+	for (int v = 0; v < n; v++) {
+		int num_out = idx->out_offsets[v + 1] - idx->out_offsets[v];
+		int num_in = idx->in_offsets[v + 1] - idx->in_offsets[v];
+		if (num_out > stats->max_out) {
+			stats->max_out = num_out;
+		}
+		if (num_in > stats->max_in) {
+			stats->max_in = num_in;
+		}
+	}
+	stats->bytes = n * sizeof(*idx->cyclic)
+		+ 2 * (n + 1) * sizeof(*idx->out_offsets)
+		+ (stats->out_entries + stats->in_entries)
+		* sizeof(*idx->out_labels);
+}
+
+/**
+ * hop_index_save() - Write an index to a file.
+ * @idx: Index to save.
+ * @c: Snapshot the index was built from.
+ * @path: Name of the file to write.
+ *
+ * The file holds a header and the arrays of the index in the byte order
+ * of the machine that wrote it.
+ *
+ * Returns: True if the file was written, otherwise false.
+ */
+bool hop_index_save(const hop_index *idx, const csr_graph *c,
+		    const char *path)
+{
+	int n = idx->num_nodes;
+	file_header header;
+	FILE *f = fopen(path, "wb");
+	if (f == NULL) {
+		return false;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, HOP_MAGIC, sizeof(header.magic));
+	header.version = HOP_VERSION;
+	header.num_nodes = n;
+	header.num_edges = c->num_edges;
+	header.fingerprint = fingerprint(c);
+	header.out_entries = idx->out_offsets[n];
+	header.in_entries = idx->in_offsets[n];
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& fwrite(idx->cyclic, sizeof(*idx->cyclic), n, f) == (size_t)n
+		&& fwrite(idx->out_offsets, sizeof(int), n + 1, f)
+		== (size_t)n + 1
+		&& fwrite(idx->out_labels, sizeof(int), header.out_entries, f)
+		== (size_t)header.out_entries
+		&& fwrite(idx->in_offsets, sizeof(int), n + 1, f)
+		== (size_t)n + 1
+		&& fwrite(idx->in_labels, sizeof(int), header.in_entries, f)
+		== (size_t)header.in_entries;
+	if (fclose(f) != 0) {
+		ok = false;
+	}
+	if (!ok) {
+		remove(path);
+	}
+	return ok;
+}
+
+/**
+ * hop_index_load() - Read an index written by hop_index_save().
+ * @c: Snapshot the index is to be used with.
+ * @path: Name of the file to read.
+ *
+ * Returns: A pointer to the loaded index, or NULL if the file could not
+ * be read or does not belong to the snapshot.
+ */
+hop_index *hop_index_load(const csr_graph *c, const char *path)
+{
+	int n = c->num_nodes;
+	file_header header;
+	FILE *f = fopen(path, "rb");
+	if (f == NULL) {
+		return NULL;
+	}
+	if (fread(&header, sizeof(header), 1, f) != 1
+	    || memcmp(header.magic, HOP_MAGIC, sizeof(header.magic)) != 0
+	    || header.version != HOP_VERSION || header.num_nodes != n
+	    || header.num_edges != c->num_edges
+	    || header.fingerprint != fingerprint(c)
+	    || header.out_entries < 0 || header.in_entries < 0) {
+		fclose(f);
+		return NULL;
+	}
+
+	hop_index *idx = malloc(sizeof(*idx));
+	idx->num_nodes = n;
+	idx->cyclic = malloc((n + 1) * sizeof(*idx->cyclic));
+	idx->out_offsets = malloc((n + 1) * sizeof(*idx->out_offsets));
+	idx->out_labels = malloc((header.out_entries + 1)
+				 * sizeof(*idx->out_labels));
+	idx->in_offsets = malloc((n + 1) * sizeof(*idx->in_offsets));
+	idx->in_labels = malloc((header.in_entries + 1)
+				* sizeof(*idx->in_labels));
+
+	bool ok = fread(idx->cyclic, sizeof(*idx->cyclic), n, f) == (size_t)n
+		&& fread(idx->out_offsets, sizeof(int), n + 1, f)
+		== (size_t)n + 1
+		&& fread(idx->out_labels, sizeof(int), header.out_entries, f)
+		== (size_t)header.out_entries
+		&& fread(idx->in_offsets, sizeof(int), n + 1, f)
+		== (size_t)n + 1
+		&& fread(idx->in_labels, sizeof(int), header.in_entries, f)
+		== (size_t)header.in_entries;
+	fclose(f);
+
+	// the fingerprint only covers the graph, so a damaged or hand-made
+	// file must not be able to make a query read out of bounds
+	const unsigned char *cyclic = (const unsigned char *)idx->cyclic;
+	for (int v = 0; ok && v < n; v++) {
+		ok = cyclic[v] <= 1;
+	}
+	ok = ok && valid_labels(idx->out_offsets, idx->out_labels, n,
+				header.out_entries)
+		&& valid_labels(idx->in_offsets, idx->in_labels, n,
+				header.in_entries);
+	if (!ok) {
+		hop_index_kill(idx);
+		return NULL;
+	}
+	return idx;
+}
+
+/**
+ * hop_index_kill() - Destroy a given index.
+ * @idx: Index to destroy.
+ *
+ * Returns: Nothing.
+ */
+void hop_index_kill(hop_index *idx)
+{
+	free(idx->cyclic);
+	free(idx->out_offsets);
+	free(idx->out_labels);
+	free(idx->in_offsets);
+	free(idx->in_labels);
+	free(idx);
+}
@@ -0,0 +1,109 @@
+#ifndef __HOP_INDEX_H
+#define __HOP_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "csr.h"
+
+/*
+ * Declaration of a 2-hop reachability labeling of a CSR snapshot of a
+ * graph (see csr.h), built by pruned landmark labeling (Yano et al.,
+ * "Fast and Scalable Reachability Queries on Graphs by Pruned Labeling
+ * with Landmarks and Paths", CIKM 2013).
+ *
+ * Every node has a sorted out-label of nodes it reaches and a sorted
+ * in-label of nodes that reach it. A node reaches another exactly when
+ * the out-label of the first and the in-label of the second have a
+ * common entry, so a query is one merge of two short sorted arrays and
+ * does not depend on the size of the graph.
+ *
+ * The labeling is meant for graphs that do not change, and can be saved
+ * to a file and loaded again instead of being rebuilt.
+ *
+ * As for csr_reach(), a node counts as reachable from a source if there
+ * is a path of at least one edge to it. After use, the function
+ * hop_index_kill() must be called to de-allocate the dynamic memory
+ * used by the index.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Index type.
+typedef struct hop_index hop_index;
+
+// Label sizes of an index.
+typedef struct {
+	int num_nodes;
+	long out_entries;	// Entries of all out-labels.
+	long in_entries;	// Entries of all in-labels.
+	int max_out;		// Largest out-label.
+	int max_in;		// Largest in-label.
+	size_t bytes;		// Memory used by the labels.
+} hop_stats;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * hop_index_build() - Build a 2-hop labeling of a snapshot.
+ * @c: Snapshot to index. The index does not refer to it after building.
+ *
+ * Returns: A pointer to the new index.
+ */
+hop_index *hop_index_build(const csr_graph *c);
+
+/**
+ * hop_index_query() - See if a path exists between two nodes.
+ * @idx: Index to use.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool hop_index_query(const hop_index *idx, int src, int dest);
+
+/**
+ * hop_index_stats() - Return the label sizes of an index.
+ * @idx: Index to inspect.
+ * @stats: Filled in with the label sizes.
+ *
+ * Returns: Nothing.
+ */
+void hop_index_stats(const hop_index *idx, hop_stats *stats);
+
+/**
+ * hop_index_save() - Write an index to a file.
+ * @idx: Index to save.
+ * @c: Snapshot the index was built from.
+ * @path: Name of the file to write.
+ *
+ * Returns: True if the file was written, otherwise false.
+ */
+bool hop_index_save(const hop_index *idx, const csr_graph *c,
+		    const char *path);
+
+/**
+ * hop_index_load() - Read an index written by hop_index_save().
+ * @c: Snapshot the index is to be used with.
+ * @path: Name of the file to read.
+ *
+ * NOTE: Node ids are given in the order the nodes were inserted, so the
+ * file is only valid for a graph built from the same map. A file of a
+ * snapshot with a different number of nodes or edges is rejected, and
+ * so is a file whose offsets go back or whose labels are unsorted or
+ * name no node.
+ *
+ * Returns: A pointer to the loaded index, or NULL if the file could not
+ * be read or does not belong to the snapshot.
+ */
+hop_index *hop_index_load(const csr_graph *c, const char *path);
+
+/**
+ * hop_index_kill() - Destroy a given index.
+ * @idx: Index to destroy.
+ *
+ * Returns: Nothing.
+ */
+void hop_index_kill(hop_index *idx);
+
+#endif
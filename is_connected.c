@@ -1,10 +1,21 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "graph.h"
+#include "csr.h"
+#include "bfs.h"
+#include "map.h"
+#include "reach_index.h"
+#include "hop_index.h"
+#include "dijkstra.h"
+#include "path.h"
 #include "dlist.h"
 #include "util.h"
 #include "queue.h"
@@ -12,6 +23,83 @@
 
 //global var
 int num_of_edges;
+
+// search modes that can be selected with -m, in the order of mode_names
+typedef enum {
+  MODE_BFS,
+  MODE_CSR,
+  MODE_BIDIR,
+  MODE_DIROP,
+  MODE_PARALLEL,
+  MODE_INDEX,
+  MODE_HOP,
+  MODE_ROUTE,
+  MODE_UNDIRECTED,
+  NUM_MODES
+} search_mode;
+
+const char *mode_names[NUM_MODES] = {"bfs", "csr", "bidir", "dirop",
+"parallel", "index", "hop", "route", "undirected"};
+
+// description of each mode for the usage text, in the order of mode_names
+const char *mode_help[NUM_MODES] = {
+  "search the graph with find_path() and print the route (default)",
+  "search a frozen CSR snapshot of the graph and print the route",
+  "bidirectional search on a frozen CSR snapshot, prints the route",
+  "direction-optimizing BFS on a frozen CSR snapshot, no route",
+  "multi-threaded BFS on a frozen CSR snapshot (see -t), no route",
+  "reachability index over strongly connected components, no route",
+  "2-hop labels in <map>.hop, rebuilt if missing or stale, no route",
+  "cheapest routes by Dijkstra on a frozen snapshot, using edge weights",
+  "union-find components for maps listing routes both ways, no route",
+};
+
+// node orders that can be selected with -r, in the order of graph_order
+const char *order_names[] = {"bfs", "rcm", "degree"};
+#define NUM_ORDERS (int)(sizeof(order_names) / sizeof(order_names[0]))
+
+// number of GRAIL interval labels of the reachability index
+#define INDEX_LABELS 3
+
+// default number of answers cached between prompts
+#define CACHE_SIZE 1024
+
+// batch groups of fewer queries are answered one by one by the chosen engine
+#define MULTI_MIN_QUERIES 8
+
+// search mode together with the structures it searches
+typedef struct {
+  search_mode mode;
+  int threads;
+  csr_graph *frozen;
+  reach_index *index;
+  hop_index *hop;
+  dijkstra *route;
+  path_finder *paths;
+  csr_scratch *scratch;
+} searcher;
+
+// answers to the queries of a batch
+typedef enum {
+  BATCH_PATH,
+  BATCH_NO_PATH,
+  BATCH_NO_ORIGIN,
+  BATCH_NO_DEST
+} batch_result;
+
+// origin/destination pair of a batch, names can be maximum of 40 chars
+typedef struct {
+  char origin[41];
+  char dest[41];
+} batch_pair;
+
+// query of a batch sorted by origin, index is its position in the input
+typedef struct {
+  int src;
+  int dest;
+  int index;
+} batch_query;
+
 /* how to run
 gcc -std=c99 -Wall -o main is_connected.c graph.c dlist.c
 ./main airmap1.map
@@ -22,217 +110,676 @@ gcc -std=c99 -Wall -o main is_connected.c graph.c dlist.c
 */
 
 
-  /**
-   * ingore_white_space()- check if a char array starts with white spaces,
-   * ignore them if true
-   * @g: char to inspect.
-   *
-   * Iterates over the graph and prints its contents.
-   *
-   * Returns: NULL if line only consists of white spaces,
-   * else modified line with removed initial white spaces
-   */
-char *ignore_white_space(char *line){
-  bool white_space = true;
-  int length = strlen(line);
-  int char_count = 0;
-  while(white_space){
-    // se if char at char_count is white space character
-    if(isspace(line[char_count])!=0){
-      char_count++;
-      // if the whole line contains spaces set line value to null and jump
-      // out of loop
-      if(length == char_count){
-        line = 0;
-        white_space = false;
-      };
-
-    }else{
-      /* see if line has contained white space (char_count=0),
-      * if true -> jump out of loop without modifying
-      * if false -> modify line to remove white spaces
-      */
-      if(char_count == 0){
-        white_space=false;
-      }else{
-        // allocate space for a line that will copy the non white_space chars
-        char *new_line = calloc(256,sizeof(char));
-
-        /* copy the chars from the first non-white-space to the new char array,
-         * modify and overwrite the old chars in the original char array*/
-        for(int j = 0; j< length; j++){
-          new_line[j]= line[char_count];
-          line[j]=new_line[j];
-          char_count++;
-        }
-        free(new_line);
-        white_space = false;
-      }
-    }
-  };
-
-  return line;
-};
+void add_to_queue(queue *q, graph *g, node *n){
+  queue_enqueue(q,n);
+  graph_node_set_seen(g, n, true);
+}
 
-/* build_graph() - builds graph from file
-* @map - File from which graph is built
-*
-* NOTE - File must contain same amount of edges as declared
+/* find_path() - See if path exists between source node and destination node.
+* @g - Graph to inspect1.
+* @src - Source node.
+* @dest - Destination node.
+* @parents - NULL, or graph_node_count() entries that get the id of the node
+* each reached node was found from, for path_unwind().
+* @q - Counters of the query, the work of the search is added to them.
 *
-* Returns - A new graph with nodes and edges
+* Returns - true if path exists, else false
 */
-graph *build_graph(FILE *map){
-  // create buffer string assbmad each line contains less than 256 chars
-  graph *g = NULL;
-  int buff_size = 256;
-  char *buff = calloc(buff_size,sizeof(char));
-  int edge_count = 0;
+bool find_path(graph *g,node *src,node *dest,int *parents,query_counters *q){
+   node *src_node = src;
+   node *dest_node = dest;
+   // every node is queued at most once, so the ring never has to grow
+   queue *q_nodes = queue_with_capacity(NULL, graph_node_count(g) + 1);
+   int queued = 1;
+   bool found = false;
 
+   add_to_queue(q_nodes,g,src_node);
 
+   while(!found && !queue_is_empty(q_nodes)){
+     // get node from queue and check if node is destination node
+     // and get the out-edges of the node first in queue
+     node *first_node = queue_front(q_nodes);
+     edge *out = graph_first_edge(g, first_node);
+     q->dequeued++;
+
+     //iterate through the out-edges, no neighbour list has to be built
+     while(out != NULL){
+       // get node from edge and check if node is destination node
+       node *inspected_node = graph_edge_target(g, out);
+       q->scanned++;
+       bool is_dest = nodes_are_equal(inspected_node, dest_node);
+       if(parents != NULL && (is_dest
+       || !graph_node_is_seen(g, inspected_node))){
+         parents[graph_node_id(g, inspected_node)] = graph_node_id(g,
+         first_node);
+       };
+       if(is_dest){
+         found = true;
+         break;
+       };
+       // if neighbour node is not seen, add to queue
+       if(!graph_node_is_seen(g, inspected_node)){
+         add_to_queue(q_nodes,g,inspected_node);
+         queued++;
+       };
 
-  // read file line by line
-  while(fgets(buff, buff_size, map) != NULL){
+       out = graph_next_edge(g, out);
+     };
+     if(queued > q->peak_queue){
+       q->peak_queue = queued;
+     };
 
+     // when all neighbours have been checked delete from queue
+     queue_dequeue(q_nodes);
+     queued--;
+   };
 
-    // check if line is comment, if true skip line
-    if (buff[0] == '#') {
-      continue;
+  q->allocations += queue_allocations(q_nodes);
+  queue_kill(q_nodes);
 
-    //check if line starts with a digit, indicates number of edges in graph
-    // store create graph with max number of nodes and continue
-    }else if(isdigit(buff[0]) ){
-      num_of_edges = atoi(&buff[0]);
-      g = graph_empty(2*num_of_edges);
-      continue;
-    }else{
+  graph_reset_seen(g);
+  return found;
+};
 
-      /* checks if buffer starts with white spaces and removes them if true
-      * returns NULL if buffer only contains whitespaces, if true -> continue to
-      * next line
-      */
-      char *line = ignore_white_space(buff);
-      if(line == NULL){
-        continue;
-      };
+/* usage() - print how to run the program and exit
+* @name - Name of the program
+*/
+void usage(const char *name){
+  fprintf(stderr, "Usage: %s [-m mode] [-t threads] [-c entries] "
+  "[-b pairs] [-r order] 'mapname'.map|.snap\n", name);
+  for(int i = 0; i < NUM_MODES; i++){
+    fprintf(stderr, "  -m %-10s %s\n", mode_names[i], mode_help[i]);
+  };
+  fprintf(stderr, "  -t %-10s %s\n", "threads",
+  "threads used by -m parallel and for loading (default: one per core)");
+  fprintf(stderr, "  -c %-10s %s\n", "entries",
+  "answers cached between prompts (default: 1024, 0 disables),\n"
+  "                a cached path is searched again for its route");
+  fprintf(stderr, "  -b %-10s %s\n", "pairs",
+  "answer the origin/destination pairs in file pairs (- for stdin)");
+  fprintf(stderr, "  -r %-10s %s\n", "order",
+  "renumber the nodes for locality before searching: bfs, rcm or degree");
+  exit(EXIT_FAILURE);
+};
 
-      //node names can be maximum of 40 chars
-      char *origin_name = (char*)malloc(40*sizeof(char)+1);
-      char *dest_name = (char*)malloc(40*sizeof(char)+1);
+/* search() - See if path exists between two nodes using a search mode.
+* @s - Search mode and the structures it uses.
+* @g - Graph to inspect.
+* @src - Source node.
+* @dest - Destination node.
+* @q - Counters of the query, the searches add what they count to them.
+*
+* Returns - true if path exists, else false
+*/
+bool search(const searcher *s, graph *g, node *src, node *dest,
+query_counters *q){
+  int src_id = graph_node_id(g, src);
+  int dest_id = graph_node_id(g, dest);
+  const csr_graph *frozen = s->frozen;
+
+  switch(s->mode){
+  case MODE_CSR:
+    return csr_find_path(frozen, src_id, dest_id, s->scratch, q);
+  case MODE_BIDIR:
+    return csr_find_path_bidir(frozen, src_id, dest_id, s->scratch, q);
+  case MODE_DIROP:
+    return bfs_dirop_find_path(frozen, src_id, dest_id, &q->scanned);
+  case MODE_PARALLEL:
+    return bfs_parallel_find_path(frozen, src_id, dest_id, s->threads,
+    &q->scanned);
+  case MODE_INDEX:
+    return reach_index_query(s->index, src_id, dest_id);
+  case MODE_HOP:
+    return hop_index_query(s->hop, src_id, dest_id);
+  case MODE_ROUTE:
+    return dijkstra_distance(s->route, src_id, dest_id, q) >= 0;
+  case MODE_UNDIRECTED:
+    return graph_nodes_connected(g, src, dest);
+  default:
+    return find_path(g, src, dest, NULL, q);
+  };
+};
 
-      // see if nodes is already in graph: if not -> insert nodes
+/* find_route() - Find a path and its hops using a search mode.
+* @s - Search mode and the structures it uses, MODE_BFS, MODE_CSR,
+* MODE_BIDIR or MODE_ROUTE.
+* @g - Graph to inspect.
+* @src - Source node.
+* @dest - Destination node.
+* @parents - graph_node_count() parent ids for find_path() in MODE_BFS.
+* @route - Filled in with the ids of the path, origin first.
+* @cost - Set to the cost of the path in MODE_ROUTE, else left as it is.
+* @q - Counters of the query, the searches add what they count to them.
+*
+* Returns - the number of nodes of the route, or 0 if there is no path
+*/
+int find_route(const searcher *s, graph *g, node *src, node *dest,
+int *parents, int *route, long *cost, query_counters *q){
+  int src_id = graph_node_id(g, src);
+  int dest_id = graph_node_id(g, dest);
+
+  switch(s->mode){
+  case MODE_CSR:
+    return path_finder_find(s->paths, src_id, dest_id, route, q);
+  case MODE_BIDIR:
+    return csr_route_bidir(s->frozen, src_id, dest_id, s->scratch, route, q);
+  case MODE_ROUTE:
+    return dijkstra_route(s->route, src_id, dest_id, route, cost, q);
+  default:
+    if(!find_path(g, src, dest, parents, q)){
+      return 0;
+    };
+    return path_unwind(parents, src_id, dest_id, route);
+  };
+};
 
-      node *origin_node =graph_find_node(g,origin_name);
-      node *destination_node = graph_find_node(g,dest_name);
+/* compare_queries() - qsort comparator ordering batch queries by origin
+* @a - First batch_query.
+* @b - Second batch_query.
+*
+* Returns - negative, zero or positive as a is before, with or after b
+*/
+int compare_queries(const void *a, const void *b){
+  const batch_query *q1 = a;
+  const batch_query *q2 = b;
+  if(q1->src != q2->src){
+    return q1->src < q2->src ? -1 : 1;
+  };
+  return q1->index - q2->index;
+};
 
-      if(origin_node == NULL){
-        g=graph_insert_node(g,origin_name);
-        origin_node = graph_find_node(g,origin_name);
-      };
+/* read_pairs() - read origin/destination pairs, one pair per line
+* @in - File to read from. Empty lines and lines starting with # are skipped.
+* @num_pairs - Set to the number of pairs read.
+*
+* Returns - Array of pairs, must be freed after use
+*/
+batch_pair *read_pairs(FILE *in, int *num_pairs){
+  int size = 1024;
+  int count = 0;
+  batch_pair *pairs = malloc(size * sizeof(*pairs));
+  char buff[256];
+
+  while(fgets(buff, sizeof(buff), in) != NULL){
+    if(count == size){
+      size *= 2;
+      pairs = realloc(pairs, size * sizeof(*pairs));
+    };
+    if(buff[0] == '#'){
+      continue;
+    };
+    if(sscanf(buff, "%40s %40s", pairs[count].origin, pairs[count].dest)
+    == 2){
+      count++;
+    };
+  };
 
-      if(destination_node == NULL){
-        g=graph_insert_node(g,dest_name);
-        destination_node = graph_find_node(g,dest_name);
-      };
+  *num_pairs = count;
+  return pairs;
+};
 
-      graph_insert_edge(g,origin_node,destination_node);
+/* is_snapshot() - See if a file is named as a binary snapshot.
+* @path - Name of the file.
+*
+* Returns - true if the name ends in .snap, else false
+*/
+bool is_snapshot(const char *path){
+  size_t len = strlen(path);
+  return len >= strlen(".snap") && strcmp(path + len - strlen(".snap"),
+  ".snap") == 0;
+};
 
-      edge_count++;
-      free(origin_name);
-      free(dest_name);
+/* open_hop_index() - Load the 2-hop labels of a map, or build them.
+* @frozen - Snapshot of the graph read from the map.
+* @map_name - Name of the map file, the labels are kept in map_name.hop.
+*
+* Labels that are missing or were built from another version of the map
+* are rebuilt and saved. The label sizes are reported on stderr.
+*
+* Returns - The labels of the map
+*/
+hop_index *open_hop_index(const csr_graph *frozen, const char *map_name){
+  char *path = malloc(strlen(map_name) + strlen(".hop") + 1);
+  sprintf(path, "%s.hop", map_name);
+
+  hop_index *hop = hop_index_load(frozen, path);
+  if(hop == NULL){
+    hop = hop_index_build(frozen);
+    if(!hop_index_save(hop, frozen, path)){
+      fprintf(stderr, "Labels could not be saved to %s\n", path);
     };
-
   };
 
-  if(edge_count != num_of_edges){
-    fprintf(stderr, "inserted %d edges when the needes to be %d edges\n",
-    edge_count, num_of_edges );
-    fclose(map);
-    free(buff);
-    graph_kill(g);
-    exit(EXIT_FAILURE);
-  };
+  hop_stats stats;
+  hop_index_stats(hop, &stats);
+  int nodes = stats.num_nodes > 0 ? stats.num_nodes : 1;
+  fprintf(stderr, "2-hop labels: %d nodes, %ld out and %ld in entries "
+  "(mean %.2f/%.2f, max %d/%d), %zu bytes\n", stats.num_nodes,
+  stats.out_entries, stats.in_entries, (double)stats.out_entries / nodes,
+  (double)stats.in_entries / nodes, stats.max_out, stats.max_in,
+  stats.bytes);
+  free(path);
+  return hop;
+};
 
+/* nanos_now() - Read the monotonic clock.
+*
+* Returns - The current time in nanoseconds
+*/
+long nanos_now(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+};
 
-  fclose(map);
-  free(buff);
-  return g;
+/* print_stats() - Print what the searched queries have cost so far.
+* @g - Graph the queries were recorded in.
+*
+* Returns - Nothing
+*/
+void print_stats(const graph *g){
+  query_summary sum;
+  long hits, misses;
+  if(!graph_stats(g, &sum) || sum.queries == 0){
+    printf("No queries have been searched.\n");
+    return;
+  };
+  graph_cache_counts(g, &hits, &misses);
+  double n = sum.queries;
+  printf("Searched queries: %ld (cache: %ld hits, %ld misses)\n",
+  sum.queries, hits, misses);
+  printf("Latency (us): p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, "
+  "max %.1f\n", sum.p50 / 1e3, sum.p90 / 1e3, sum.p99 / 1e3,
+  sum.p999 / 1e3, sum.max.nanos / 1e3);
+  printf("Nodes dequeued: mean %.1f, max %ld\n", sum.total.dequeued / n,
+  sum.max.dequeued);
+  printf("Edges scanned: mean %.1f, max %ld\n", sum.total.scanned / n,
+  sum.max.scanned);
+  printf("Peak queue: mean %.1f, max %ld\n", sum.total.peak_queue / n,
+  sum.max.peak_queue);
+  printf("Allocations: mean %.1f, max %ld\n", sum.total.allocations / n,
+  sum.max.allocations);
+  // the ids of the slowest query give back its names
+  node *src = graph_node_by_id(g, sum.worst_src);
+  node *dest = graph_node_by_id(g, sum.worst_dest);
+  if(src != NULL && dest != NULL){
+    printf("Slowest query: %s to %s\n", graph_node_name(g, src),
+    graph_node_name(g, dest));
+  };
 };
 
-void add_to_queue(queue *q, graph *g, node *n){
-  queue_enqueue(q,n);
-  graph_node_set_seen(g, n, true);
-}
+/* print_route() - Print the hops of a path by name.
+* @g - Graph the path was found in.
+* @route - Ids of the nodes of the path, origin first.
+* @length - Number of nodes of the path.
+*
+* Returns - Nothing
+*/
+void print_route(const graph *g, const int *route, int length){
+  printf("Route: %s", graph_node_name(g, graph_node_by_id(g, route[0])));
+  for(int i = 1; i < length; i++){
+    printf(" -> %s", graph_node_name(g, graph_node_by_id(g, route[i])));
+  };
+  printf("\n");
+};
 
-/* find_path() - See if path exists between source node and destination node.
-* @g - Graph to inspect1.
-* @src - Source node.
-* @dest - Destination node.
+/* kill_searcher() - Free the structures used by a searcher.
+* @s - Searcher to clean up, its mode and threads are kept.
 *
-* Returns - true if path exists, else false
+* Returns - Nothing
 */
-bool find_path(graph *g,node *src,node *dest){
-   node *src_node = src;
-   node *dest_node = dest;
-   queue *q = queue_empty(NULL);
+void kill_searcher(searcher *s){
+  if(s->scratch != NULL){
+    csr_scratch_kill(s->scratch);
+    s->scratch = NULL;
+  };
+  if(s->paths != NULL){
+    path_finder_kill(s->paths);
+    s->paths = NULL;
+  };
+  if(s->route != NULL){
+    dijkstra_kill(s->route);
+    s->route = NULL;
+  };
+  if(s->hop != NULL){
+    hop_index_kill(s->hop);
+    s->hop = NULL;
+  };
+  if(s->index != NULL){
+    reach_index_kill(s->index);
+    s->index = NULL;
+  };
+  if(s->frozen != NULL){
+    csr_kill(s->frozen);
+    s->frozen = NULL;
+  };
+};
 
-   add_to_queue(q,g,src_node);
+/* answer_by_search() - answer the queries of a batch by searching from
+* their origins
+* @g - Graph to inspect.
+* @s - Search mode and the structures it uses, s->frozen must be set.
+* @queries - Queries to answer, they are sorted by origin here.
+* @num_queries - Number of queries.
+* @results - Answers, indexed by the input position of the queries.
+*
+* Every destination of an origin is answered from the visited set of a
+* single BFS from the origin. MODE_PARALLEL runs that BFS with threads,
+* other modes run the BFS:s of up to BFS_MULTI_MAX origins together by
+* bfs_multi_reach(). A group of fewer than MULTI_MIN_QUERIES queries, as
+* in a small batch or at the end of one, is answered query by query by
+* search() with the chosen mode instead, since its searches stop at the
+* destination.
+*
+* Returns - Nothing
+*/
+void answer_by_search(graph *g, const searcher *s, batch_query *queries,
+int num_queries, batch_result *results){
+  const csr_graph *frozen = s->frozen;
+
+  // one BFS per distinct origin answers all of its destinations
+  qsort(queries, num_queries, sizeof(*queries), compare_queries);
+  int words = BITSET_WORDS(frozen->num_nodes);
+  uint64_t *visited = malloc((words + 1) * sizeof(*visited));
+  uint64_t *reach = malloc((frozen->num_nodes + 1) * sizeof(*reach));
+  int first = 0;
+  while(first < num_queries && s->mode == MODE_PARALLEL){
+    int src = queries[first].src;
+    memset(visited, 0, words * sizeof(*visited));
+    bfs_parallel_reach(frozen, src, visited, s->threads, NULL);
+
+    while(first < num_queries && queries[first].src == src){
+      bool found = bitset_test(visited, queries[first].dest);
+      results[queries[first].index] = found ? BATCH_PATH : BATCH_NO_PATH;
+      first++;
+    };
+  };
+  while(first < num_queries){
+    // collect the queries of the next BFS_MULTI_MAX distinct origins
+    int sources[BFS_MULTI_MAX];
+    int num_sources = 0;
+    int last = first;
+    while(last < num_queries && (num_sources < BFS_MULTI_MAX ||
+    queries[last].src == sources[num_sources - 1])){
+      if(num_sources == 0 || queries[last].src != sources[num_sources - 1]){
+        sources[num_sources++] = queries[last].src;
+      };
+      last++;
+    };
+    if(last - first < MULTI_MIN_QUERIES){
+      for(int i = first; i < last; i++){
+        query_counters q = {0};
+        bool found = search(s, g, graph_node_by_id(g, queries[i].src),
+        graph_node_by_id(g, queries[i].dest), &q);
+        results[queries[i].index] = found ? BATCH_PATH : BATCH_NO_PATH;
+      };
+      first = last;
+      continue;
+    };
+    bfs_multi_reach(frozen, sources, num_sources, reach);
 
-   while(!queue_is_empty(q)){
-     // get node from queue and check if node is destination node
-     // and get neighbour list from node first in queue
-     node *first_node = queue_front(q);
-     dlist *neighbours = graph_neighbours(g, first_node);
-
-     //iterate through neighbour list
-     dlist_pos pos = dlist_first(neighbours);
-     while(!dlist_is_end(neighbours, pos)){
-       // get node from list and check if node is destination node
-       node *inspected_node = dlist_inspect(neighbours, pos);
-       if(nodes_are_equal(inspected_node, dest_node)){
-
-         queue_kill(q);
-         graph_reset_seen(g);
-         return true;
-       };
-       // if neighbour node is not seen, add to queue
-       if(!graph_node_is_seen(g, inspected_node)){
-         add_to_queue(q,g,inspected_node);
-       };
+    // bit j of reach answers the queries of the j:th origin
+    int j = -1;
+    for(int i = first; i < last; i++){
+      if(j < 0 || queries[i].src != sources[j]){
+        j++;
+      };
+      bool found = (reach[queries[i].dest] >> j) & 1;
+      results[queries[i].index] = found ? BATCH_PATH : BATCH_NO_PATH;
+    };
+    first = last;
+  };
 
-       pos = dlist_next(neighbours, pos);
-     };
+  free(visited);
+  free(reach);
+};
 
-     // when all neighbours have been checked delete from queue
-     queue_dequeue(q);
-   };
+/* run_batch() - answer origin/destination pairs without prompting
+* @g - Graph to inspect.
+* @s - Search mode and the structures it uses.
+* @in - File with one origin/destination pair per line.
+*
+* With MODE_UNDIRECTED, MODE_INDEX, MODE_HOP and MODE_ROUTE every pair is
+* answered on its own, otherwise the pairs are answered by
+* answer_by_search(). The answers are written to stdout in input order,
+* MODE_ROUTE adds the cost of each route found.
+*
+* Returns - Nothing
+*/
+void run_batch(graph *g, const searcher *s, FILE *in){
+  int num_pairs;
+  batch_pair *pairs = read_pairs(in, &num_pairs);
+  batch_result *results = malloc((num_pairs + 1) * sizeof(*results));
+  batch_query *queries = malloc((num_pairs + 1) * sizeof(*queries));
+  long *costs = malloc((num_pairs + 1) * sizeof(*costs));
+  int num_queries = 0;
+
+  // resolve names, pairs with unknown names are answered right away
+  for(int i = 0; i < num_pairs; i++){
+    node *origin_node = graph_find_node(g, pairs[i].origin);
+    node *dest_node = graph_find_node(g, pairs[i].dest);
+    if(origin_node == NULL){
+      results[i] = BATCH_NO_ORIGIN;
+    }else if(dest_node == NULL){
+      results[i] = BATCH_NO_DEST;
+    }else if(s->mode == MODE_UNDIRECTED){
+      bool found = graph_nodes_connected(g, origin_node, dest_node);
+      results[i] = found ? BATCH_PATH : BATCH_NO_PATH;
+    }else{
+      queries[num_queries].src = graph_node_id(g, origin_node);
+      queries[num_queries].dest = graph_node_id(g, dest_node);
+      queries[num_queries].index = i;
+      num_queries++;
+    };
+  };
 
-  queue_kill(q);
+  // the indexes answer each pair on its own
+  if(s->mode == MODE_INDEX || s->mode == MODE_HOP){
+    for(int i = 0; i < num_queries; i++){
+      int src = queries[i].src;
+      int dest = queries[i].dest;
+      bool found = s->mode == MODE_HOP ? hop_index_query(s->hop, src, dest)
+      : reach_index_query(s->index, src, dest);
+      results[queries[i].index] = found ? BATCH_PATH : BATCH_NO_PATH;
+    };
+    num_queries = 0;
+  };
+  if(s->mode == MODE_ROUTE){
+    for(int i = 0; i < num_queries; i++){
+      int index = queries[i].index;
+      costs[index] = dijkstra_distance(s->route, queries[i].src,
+      queries[i].dest, NULL);
+      results[index] = costs[index] >= 0 ? BATCH_PATH : BATCH_NO_PATH;
+    };
+    num_queries = 0;
+  };
 
-  graph_reset_seen(g);
-  return false;
+  if(num_queries > 0){
+    answer_by_search(g, s, queries, num_queries, results);
+  };
+
+  // stdout is fully buffered, so the answers are written in large blocks
+  setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+  for(int i = 0; i < num_pairs; i++){
+    switch(results[i]){
+    case BATCH_PATH:
+      if(s->mode == MODE_ROUTE){
+        printf("There is a path from %s to %s, cost %ld.\n",
+        pairs[i].origin, pairs[i].dest, costs[i]);
+        break;
+      };
+      printf("There is a path from %s to %s.\n", pairs[i].origin,
+      pairs[i].dest);
+      break;
+    case BATCH_NO_PATH:
+      printf("There is no path from %s to %s.\n", pairs[i].origin,
+      pairs[i].dest);
+      break;
+    case BATCH_NO_ORIGIN:
+      printf("No origin exists with the name %s.\n", pairs[i].origin);
+      break;
+    case BATCH_NO_DEST:
+      printf("No destination exists with the name %s.\n", pairs[i].dest);
+      break;
+    };
+  };
+  fflush(stdout);
+
+  free(costs);
+  free(queries);
+  free(results);
+  free(pairs);
 };
 
 /*
 
 */
 int main(int argc, char *argv[]) {
-  // num of argummets must be 2 else print error message
-  if(argc != 2){
-    fprintf(stderr, "Compile with isConnected 'mapname'.map\n");
-    exit(EXIT_FAILURE);
+  // read search mode, the map file must be the only other argument
+  searcher s = {MODE_BFS, sysconf(_SC_NPROCESSORS_ONLN), NULL, NULL, NULL,
+  NULL, NULL, NULL};
+  char *batch = NULL;
+  int cache_size = CACHE_SIZE;
+  int order = NUM_ORDERS;
+  int opt;
+  while((opt = getopt(argc, argv, "m:t:c:b:r:")) != -1){
+    if(opt == 'r'){
+      for(order = 0; order < NUM_ORDERS; order++){
+        if(strcmp(optarg, order_names[order]) == 0){
+          break;
+        };
+      };
+      if(order == NUM_ORDERS){
+        usage(argv[0]);
+      };
+      continue;
+    };
+    if(opt == 'b'){
+      batch = optarg;
+      continue;
+    };
+    if(opt == 'c'){
+      cache_size = atoi(optarg);
+      if(cache_size < 0){
+        usage(argv[0]);
+      };
+      continue;
+    };
+    if(opt == 't'){
+      s.threads = atoi(optarg);
+      if(s.threads < 1){
+        usage(argv[0]);
+      };
+      continue;
+    };
+    if(opt != 'm'){
+      usage(argv[0]);
+    };
+    s.mode = NUM_MODES;
+    for(int i = 0; i < NUM_MODES; i++){
+      if(strcmp(optarg, mode_names[i]) == 0){
+        s.mode = i;
+      };
+    };
+    if(s.mode == NUM_MODES){
+      usage(argv[0]);
+    };
+  };
+  if(optind != argc - 1){
+    usage(argv[0]);
   }
 
-  //open and read second argbmant passed through file
-  FILE *node_map = fopen(argv[1],"r");
+  // map and read the file given as the last argument, a snapshot made by
+  // map2snap already holds the edges its map declared. The modes that
+  // only search a frozen snapshot take it straight from a snapshot file,
+  // then the graph holds the nodes but no edges.
+  map_stats stats = {0, 0, 0};
+  graph *graph;
+  bool frozen_only = s.mode != MODE_UNDIRECTED && s.mode != MODE_BFS
+  && order == NUM_ORDERS;
+  if(is_snapshot(argv[optind])){
+    graph = graph_load_binary(argv[optind], s.mode == MODE_UNDIRECTED,
+    frozen_only ? &s.frozen : NULL);
+  }else{
+    graph = map_load(argv[optind], s.mode == MODE_UNDIRECTED, s.threads,
+    &stats);
+  };
 
   //check if file exists, print error message if not
-  if( node_map == NULL){
+  if(graph == NULL){
     fprintf(stderr, "File can not be read\n");
     exit(EXIT_FAILURE);
   };
 
-  graph *graph = build_graph(node_map);
+  // the file must contain as many edges as it declares
+  num_of_edges = stats.declared_edges;
+  if(stats.edges != num_of_edges){
+    fprintf(stderr, "inserted %d edges when the needes to be %d edges\n",
+    stats.edges, num_of_edges);
+    graph_kill(graph);
+    exit(EXIT_FAILURE);
+  };
 
+  // neighbours get nearby ids, so the snapshot below is searched with
+  // fewer cache misses
+  if(order < NUM_ORDERS){
+    graph_reorder(graph, order);
+  };
+
+  // the graph does not change after loading, so a snapshot can be taken once
+  // (union-find answers without one)
+  if(s.frozen == NULL && s.mode != MODE_UNDIRECTED
+  && (s.mode != MODE_BFS || batch != NULL)){
+    s.frozen = graph_freeze(graph);
+  };
+  if(s.mode == MODE_CSR || s.mode == MODE_BIDIR){
+    s.scratch = csr_scratch_empty(s.frozen);
+  };
+  if(s.mode == MODE_INDEX){
+    s.index = reach_index_build(s.frozen, INDEX_LABELS);
+  };
+  if(s.mode == MODE_HOP){
+    s.hop = open_hop_index(s.frozen, argv[optind]);
+  };
+  if(s.mode == MODE_ROUTE){
+    s.route = dijkstra_empty(s.frozen);
+  };
+
+  // in batch mode answer all pairs and exit without prompting
+  if(batch != NULL){
+    FILE *pairs = strcmp(batch, "-") == 0 ? stdin : fopen(batch, "r");
+    if(pairs == NULL){
+      fprintf(stderr, "File can not be read\n");
+      kill_searcher(&s);
+      graph_kill(graph);
+      exit(EXIT_FAILURE);
+    };
+    run_batch(graph, &s, pairs);
+    if(pairs != stdin){
+      fclose(pairs);
+    };
+    kill_searcher(&s);
+    graph_kill(graph);
+    return 0;
+  };
+
+  graph_cache_results(graph, cache_size);
+  graph_collect_stats(graph, 1);
+  // bfs, csr, bidir and route answer with the route itself, found by one
+  // search into scratch arrays that are allocated once. The other modes
+  // keep no parents, or answer without searching.
+  int *route = NULL;
+  int *parents = NULL;
+  if(s.mode == MODE_BFS || s.mode == MODE_CSR || s.mode == MODE_BIDIR
+  || s.mode == MODE_ROUTE){
+    route = malloc((graph_node_count(graph) + 1) * sizeof(*route));
+  };
+  if(s.mode == MODE_BFS){
+    parents = malloc((graph_node_count(graph) + 1) * sizeof(*parents));
+  };
+  if(s.mode == MODE_CSR){
+    s.paths = path_finder_empty(s.frozen);
+  };
   bool running = true;
   char *input = malloc(2*40*sizeof(char));
   //node names can be maximum of 40 chars
@@ -242,8 +789,14 @@ int main(int argc, char *argv[]) {
 
 
     printf("Enter origin and destination (quit to exit): ");
-    fgets(input, 2*40, stdin);
-    sscanf(input, "%s %s", origin_name, dest_name);
+    if(fgets(input, 2*40, stdin) == NULL){
+      break;
+    };
+    int words = sscanf(input, "%s %s", origin_name, dest_name);
+    if(words == 1 && strcmp(origin_name, "stats") == 0){
+      print_stats(graph);
+      continue;
+    };
     node *origin_node = graph_find_node(graph, origin_name);
     node *dest_node = graph_find_node(graph, dest_name);
     if(strcmp(origin_name, "quit")==0){
@@ -258,16 +811,56 @@ int main(int argc, char *argv[]) {
       printf("No destination exists with that name. Try Again.\n");
       continue;
     }
-    if(find_path(graph, origin_node, dest_node)){
-      printf("There is a path from %s to %s.\n", origin_name, dest_name);
-    }else{
+    // repeated questions are answered from the cache of the graph. It
+    // keeps whether there is a path but not the route, so a cached "no
+    // path" is answered without a search and a route is searched again.
+    bool found;
+    bool cached = graph_cache_lookup(graph, origin_node, dest_node, &found);
+    int length = 0;
+    long cost = -1;
+    if(!cached || (found && route != NULL)){
+      // every search is timed and its counters recorded for stats
+      query_counters q = {0, 0, 0, 0, 0};
+      long start = nanos_now();
+      if(route != NULL){
+        length = find_route(&s, graph, origin_node, dest_node, parents,
+        route, &cost, &q);
+        found = length > 0;
+      }else{
+        found = search(&s, graph, origin_node, dest_node, &q);
+      };
+      q.nanos = nanos_now() - start;
+      graph_record_query(graph, 0, origin_node, dest_node, &q);
+      if(!cached){
+        graph_cache_store(graph, origin_node, dest_node, found);
+      };
+    };
+    if(!found){
       printf("There is no path from %s to %s.\n", origin_name, dest_name);
-    }
+    }else if(cost >= 0){
+      printf("There is a path from %s to %s, cost %ld.\n", origin_name,
+      dest_name, cost);
+    }else{
+      printf("There is a path from %s to %s.\n", origin_name, dest_name);
+    };
+    if(length > 0){
+      print_route(graph, route, length);
+    };
+  };
+
+  // the counts tell whether the cache is large enough
+  if(cache_size > 0){
+    long hits, misses;
+    graph_cache_counts(graph, &hits, &misses);
+    fprintf(stderr, "Cache: %ld hits, %ld misses\n", hits, misses);
   };
 
+  free(route);
+  free(parents);
   free(input);
   free(origin_name);
   free(dest_name);
+  kill_searcher(&s);
   graph_kill(graph);
   return 0;
 
@@ -0,0 +1,719 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "map.h"
+
+/*
+ * Implementation of a memory-mapping loader for map files.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+// Contents of a map file, memory-mapped or read into a buffer.
+typedef struct {
+	char *data;
+	size_t size;
+	bool mapped;
+} map_file;
+
+// What a line of a map file holds.
+typedef enum {
+	LINE_SKIP,		// A comment or a blank line.
+	LINE_COUNT,		// The number of edges.
+	LINE_EDGE,		// An origin and a destination.
+	LINE_BAD		// Anything else.
+} line_kind;
+
+// Name of an edge line, a slice of the file.
+typedef struct {
+	const char *name;
+	int len;
+	unsigned int hash;
+} token;
+
+// Growable array of ints.
+typedef struct {
+	int *items;
+	int count;
+	int capacity;
+} int_list;
+
+// Slot of the name table of a partition.
+typedef struct {
+	const token *tok;	// NULL if the slot is free.
+	int first;		// Index of the first occurrence of the name.
+} name_slot;
+
+struct parallel_map;
+
+/*
+ * Per-thread state of the parallel loader. Thread t tokenizes the t:th
+ * chunk of the file, then resolves the names whose hash falls into
+ * partition t.
+ */
+struct map_chunk {
+	struct parallel_map *shared;
+	int thread;
+	const char *start;
+	const char *end;
+	token *tokens;		// Names of the edge lines, two per line.
+	int num_tokens;
+	int capacity;
+	int offset;		// Index of tokens[0] among all names.
+	int_list *parts;	// Indices into tokens, one list per partition.
+	int_list bad;		// Offsets of the bad lines from start.
+	int_list weights;	// Weights of the edge lines.
+	int first_count;	// First number of edges of the chunk, or -1.
+	int last_count;		// Last number of edges of the chunk, or -1.
+};
+
+/*
+ * State shared by the threads of the parallel loader. Names are
+ * numbered in file order across the chunks. first[i] is the number of
+ * the first occurrence of the name of number i, and nodes[i] becomes
+ * its node.
+ */
+struct parallel_map {
+	int num_threads;
+	struct map_chunk *chunks;
+	int *first;
+	node **nodes;
+};
+
+// Smallest part of a file worth giving to a thread of its own.
+#define MIN_CHUNK (1 << 18)
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * open_map() - Memory-map a file, or read it if it cannot be mapped.
+ * @path: Name of the file.
+ * @f: Filled in with the contents of the file.
+ *
+ * Returns: True if the contents could be read, otherwise false.
+ */
+static bool open_map(const char *path, map_file *f)
+{
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	f->data = NULL;
+	f->size = 0;
+	f->mapped = false;
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd,
+			       0);
+		if (p != MAP_FAILED) {
+			posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+			f->data = p;
+			f->size = st.st_size;
+			f->mapped = true;
+			close(fd);
+			return true;
+		}
+	}
+
+	// pipes and the like are read in growing blocks
+	size_t capacity = 1 << 16;
+	f->data = malloc(capacity);
+	for (;;) {
+		if (f->size == capacity) {
+			capacity *= 2;
+			f->data = realloc(f->data, capacity);
+		}
+		ssize_t n = read(fd, f->data + f->size, capacity - f->size);
+		if (n < 0) {
+			free(f->data);
+			close(fd);
+			return false;
+		}
+		if (n == 0) {
+			break;
+		}
+		f->size += n;
+	}
+	close(fd);
+	return true;
+}
+
+/**
+ * close_map() - Release the contents of a file.
+ * @f: Contents to release.
+ *
+ * Returns: Nothing.
+ */
+static void close_map(map_file *f)
+{
+	if (f->mapped) {
+		munmap(f->data, f->size);
+	} else {
+		free(f->data);
+	}
+}
+
+/**
+ * is_blank() - See if a character separates names.
+ * @c: Character to inspect.
+ *
+ * Returns: True for white space and '\0', otherwise false.
+ */
+static bool is_blank(char c)
+{
+	return c == '\0' || isspace((unsigned char)c);
+}
+
+/**
+ * scan_name() - Find the next name of a line.
+ * @p: Where to start, moved past the name.
+ * @end: End of the line.
+ * @len: Set to the length of the name, 0 if there is none.
+ *
+ * Skips white space, then takes at most MAP_NAME_MAX characters up to
+ * the next white space, as scanf("%40s") does.
+ *
+ * Returns: The start of the name.
+ */
+static const char *scan_name(const char **p, const char *end, size_t *len)
+{
+	const char *q = *p;
+	while (q < end && *q != '\0' && isspace((unsigned char)*q)) {
+		q++;
+	}
+	const char *start = q;
+	while (q < end && !is_blank(*q) && q - start < MAP_NAME_MAX) {
+		q++;
+	}
+	*len = q - start;
+	*p = q;
+	return start;
+}
+
+/**
+ * new_graph() - Create an empty graph.
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @max_nodes: The number of nodes to size the graph for.
+ *
+ * Returns: A pointer to the new graph.
+ */
+static graph *new_graph(bool undirected, int max_nodes)
+{
+	return undirected ? graph_empty_undirected(max_nodes)
+		: graph_empty(max_nodes);
+}
+
+/**
+ * node_hint() - Return the number of nodes to size a graph for.
+ * @count: Number of edges the map declares.
+ * @bytes: Size of the contents of the map.
+ *
+ * An edge line takes at least four bytes and adds at most two nodes, so
+ * a count larger than the file can hold does not size the graph beyond
+ * what the file can fill.
+ *
+ * Returns: The smaller of 2 * count and bytes / 2.
+ */
+static int node_hint(int count, size_t bytes)
+{
+	size_t fit = bytes / 2;
+	return 2 * (size_t)count < fit ? 2 * count : (int)fit;
+}
+
+/**
+ * scan_weight() - Read the weight that may follow the names of a line.
+ * @p: End of the destination name.
+ * @end: End of the line.
+ *
+ * Returns: The weight, or 1 if the next word is not a whole number of
+ * at most MAP_WEIGHT_MAX.
+ */
+static int scan_weight(const char *p, const char *end)
+{
+	// the rest of a name cut at MAP_NAME_MAX is no weight
+	if (p < end && !is_blank(*p)) {
+		return 1;
+	}
+	size_t len;
+	const char *word = scan_name(&p, end, &len);
+	long weight = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (!isdigit((unsigned char)word[i])) {
+			return 1;
+		}
+		weight = 10 * weight + (word[i] - '0');
+		if (weight > MAP_WEIGHT_MAX) {
+			return 1;
+		}
+	}
+	return len == 0 ? 1 : weight;
+}
+
+/**
+ * scan_line() - Find out what a line of a map file holds.
+ * @line: Start of the line.
+ * @eol: End of the line.
+ * @num: Set to the number of edges of a LINE_COUNT line, at most
+ * MAP_COUNT_MAX.
+ * @names: Set to the origin and destination of a LINE_EDGE line.
+ * @lens: Set to the lengths of the names of a LINE_EDGE line.
+ * @weight: Set to the weight of a LINE_EDGE line.
+ *
+ * Returns: The kind of the line.
+ */
+static line_kind scan_line(const char *line, const char *eol, int *num,
+			   const char **names, size_t *lens, int *weight)
+{
+	if (line == eol || *line == '#') {
+		return LINE_SKIP;
+	}
+	if (isdigit((unsigned char)*line)) {
+		// the count is bounded before it can overflow an int
+		*num = 0;
+		for (const char *q = line;
+		     q < eol && isdigit((unsigned char)*q); q++) {
+			if (*num > (MAP_COUNT_MAX - (*q - '0')) / 10) {
+				return LINE_BAD;
+			}
+			*num = 10 * *num + (*q - '0');
+		}
+		return LINE_COUNT;
+	}
+
+	const char *q = line;
+	names[0] = scan_name(&q, eol, &lens[0]);
+	if (lens[0] == 0 && q == eol) {
+		// nothing but white space
+		return LINE_SKIP;
+	}
+	names[1] = scan_name(&q, eol, &lens[1]);
+	if (lens[0] == 0 || lens[1] == 0) {
+		return LINE_BAD;
+	}
+	*weight = scan_weight(q, eol);
+	return LINE_EDGE;
+}
+
+/**
+ * next_line() - Find the end of a line.
+ * @p: Start of the line.
+ * @end: End of the contents.
+ *
+ * Returns: The newline ending the line, or end if there is none.
+ */
+static const char *next_line(const char *p, const char *end)
+{
+	const char *eol = memchr(p, '\n', end - p);
+	return eol == NULL ? end : eol;
+}
+
+/**
+ * report_bad() - Report a line that is neither a comment nor an edge.
+ * @line: Start of the line.
+ * @end: End of the contents.
+ *
+ * Returns: Nothing.
+ */
+static void report_bad(const char *line, const char *end)
+{
+	fprintf(stderr, "Line does not contain an edge: %.*s\n",
+		(int)(next_line(line, end) - line), line);
+}
+
+/**
+ * parse_map() - Build a graph from the contents of a map file.
+ * @p: Start of the contents.
+ * @end: End of the contents.
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @stats: Filled in with what the contents held.
+ *
+ * Returns: The new graph.
+ */
+static graph *parse_map(const char *p, const char *end, bool undirected,
+			map_stats *stats)
+{
+	graph *g = NULL;
+
+	while (p < end) {
+		const char *eol = next_line(p, end);
+		const char *line = p;
+		const char *names[2];
+		size_t lens[2];
+		int num, weight;
+		p = eol + 1;
+
+		switch (scan_line(line, eol, &num, names, lens, &weight)) {
+		case LINE_SKIP:
+			break;
+		case LINE_COUNT:
+			// the number of edges, it also sizes the graph
+			stats->declared_edges = num;
+			if (g == NULL) {
+				g = new_graph(undirected,
+					      node_hint(num, end - line));
+			}
+			break;
+		case LINE_BAD:
+			report_bad(line, end);
+			stats->bad_lines++;
+			break;
+		case LINE_EDGE:
+			if (g == NULL) {
+				g = new_graph(undirected, 0);
+			}
+			node *n1 = graph_intern_node(g, names[0], lens[0]);
+			node *n2 = graph_intern_node(g, names[1], lens[1]);
+			graph_insert_weighted_edge(g, n1, n2, weight);
+			stats->edges++;
+			break;
+		}
+	}
+
+	if (g == NULL) {
+		g = new_graph(undirected, 0);
+	}
+	return g;
+}
+
+/**
+ * list_push() - Append a value to a growable array.
+ * @l: Array to modify.
+ * @value: Value to append.
+ *
+ * Returns: Nothing.
+ */
+static void list_push(int_list *l, int value)
+{
+	if (l->count == l->capacity) {
+		l->capacity = l->capacity == 0 ? 64 : 2 * l->capacity;
+		l->items = realloc(l->items, l->capacity * sizeof(*l->items));
+	}
+	l->items[l->count++] = value;
+}
+
+/**
+ * push_token() - Append a name to the names of a chunk.
+ * @ch: Chunk to modify.
+ * @name: Start of the name.
+ * @len: Length of the name.
+ *
+ * Returns: Nothing.
+ */
+static void push_token(struct map_chunk *ch, const char *name, size_t len)
+{
+	if (ch->num_tokens == ch->capacity) {
+		ch->capacity = ch->capacity == 0 ? 1024 : 2 * ch->capacity;
+		ch->tokens = realloc(ch->tokens,
+				     ch->capacity * sizeof(*ch->tokens));
+	}
+	// FNV-1a, the partition is taken from the low bits
+	unsigned int h = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		h ^= (unsigned char)name[i];
+		h *= 16777619u;
+	}
+	token *tok = &ch->tokens[ch->num_tokens];
+	tok->name = name;
+	tok->len = len;
+	tok->hash = h;
+	list_push(&ch->parts[h % ch->shared->num_threads], ch->num_tokens);
+	ch->num_tokens++;
+}
+
+/**
+ * tokenize_chunk() - Thread body of the first phase of the parallel
+ * loader: split the lines of a chunk into names.
+ * @arg: Pointer to a struct map_chunk.
+ *
+ * Returns: NULL.
+ */
+static void *tokenize_chunk(void *arg)
+{
+	struct map_chunk *ch = arg;
+	const char *p = ch->start;
+
+	while (p < ch->end) {
+		const char *eol = next_line(p, ch->end);
+		const char *line = p;
+		const char *names[2];
+		size_t lens[2];
+		int num, weight;
+		p = eol + 1;
+
+		switch (scan_line(line, eol, &num, names, lens, &weight)) {
+		case LINE_SKIP:
+			break;
+		case LINE_COUNT:
+			if (ch->first_count < 0) {
+				ch->first_count = num;
+			}
+			ch->last_count = num;
+			break;
+		case LINE_BAD:
+			list_push(&ch->bad, line - ch->start);
+			break;
+		case LINE_EDGE:
+			push_token(ch, names[0], lens[0]);
+			push_token(ch, names[1], lens[1]);
+			list_push(&ch->weights, weight);
+			break;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * resolve_partition() - Thread body of the second phase of the parallel
+ * loader: find the first occurrence of every name of a partition.
+ * @arg: Pointer to a struct map_chunk, whose thread is the partition.
+ *
+ * The occurrences are visited chunk by chunk, so in file order.
+ *
+ * Returns: NULL.
+ */
+static void *resolve_partition(void *arg)
+{
+	struct map_chunk *me = arg;
+	struct parallel_map *pm = me->shared;
+	int count = 0;
+	for (int t = 0; t < pm->num_threads; t++) {
+		count += pm->chunks[t].parts[me->thread].count;
+	}
+
+	unsigned int size = 16;
+	while (size < 2 * (unsigned int)count) {
+		size *= 2;
+	}
+	name_slot *table = calloc(size, sizeof(*table));
+
+	for (int t = 0; t < pm->num_threads; t++) {
+		const struct map_chunk *ch = &pm->chunks[t];
+		const int_list *part = &ch->parts[me->thread];
+		for (int k = 0; k < part->count; k++) {
+			const token *tok = &ch->tokens[part->items[k]];
+			unsigned int i = (tok->hash / pm->num_threads)
+				& (size - 1);
+			while (table[i].tok != NULL
+			       && (table[i].tok->hash != tok->hash
+				   || table[i].tok->len != tok->len
+				   || memcmp(table[i].tok->name, tok->name,
+					     tok->len) != 0)) {
+				i = (i + 1) & (size - 1);
+			}
+			if (table[i].tok == NULL) {
+				table[i].tok = tok;
+				table[i].first = ch->offset + part->items[k];
+			}
+			pm->first[ch->offset + part->items[k]] = table[i].first;
+		}
+	}
+	free(table);
+	return NULL;
+}
+
+/**
+ * spread_nodes() - Thread body of the third phase of the parallel
+ * loader: give every name of a chunk the node of its first occurrence.
+ * @arg: Pointer to a struct map_chunk.
+ *
+ * Returns: NULL.
+ */
+static void *spread_nodes(void *arg)
+{
+	struct map_chunk *ch = arg;
+	struct parallel_map *pm = ch->shared;
+	for (int i = ch->offset; i < ch->offset + ch->num_tokens; i++) {
+		if (pm->first[i] != i) {
+			pm->nodes[i] = pm->nodes[pm->first[i]];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * run_threads() - Run a thread body once per chunk.
+ * @pm: State of the parallel loader.
+ * @body: Thread body, called with a pointer to a struct map_chunk.
+ *
+ * The calling thread runs the body of chunk 0, and of every chunk whose
+ * thread could not be created. The chunks do not wait for each other,
+ * so the result is the same.
+ *
+ * Returns: Nothing.
+ */
+static void run_threads(struct parallel_map *pm, void *(*body)(void *))
+{
+	pthread_t *threads = malloc(pm->num_threads * sizeof(*threads));
+	bool *started = calloc(pm->num_threads, sizeof(*started));
+	for (int t = 1; t < pm->num_threads; t++) {
+		started[t] = pthread_create(&threads[t], NULL, body,
+					    &pm->chunks[t]) == 0;
+	}
+	for (int t = 0; t < pm->num_threads; t++) {
+		if (!started[t]) {
+			body(&pm->chunks[t]);
+		}
+	}
+	for (int t = 1; t < pm->num_threads; t++) {
+		if (started[t]) {
+			pthread_join(threads[t], NULL);
+		}
+	}
+	free(started);
+	free(threads);
+}
+
+/**
+ * parse_map_parallel() - Build a graph from the contents of a map file
+ * with threads.
+ * @p: Start of the contents.
+ * @end: End of the contents.
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @num_threads: Number of threads to use, at least 2.
+ * @stats: Filled in with what the contents held.
+ *
+ * The contents are cut into one chunk per thread at line boundaries.
+ * The threads tokenize their chunks, then each resolves the names of
+ * one hash partition to their first occurrences. Only the nodes of
+ * first occurrences are created, and all edges inserted, by the calling
+ * thread in file order, so the graph gets the same ids and edge order
+ * as from parse_map().
+ *
+ * Returns: The new graph.
+ */
+static graph *parse_map_parallel(const char *p, const char *end,
+				 bool undirected, int num_threads,
+				 map_stats *stats)
+{
+	struct parallel_map pm;
+	pm.num_threads = num_threads;
+	pm.chunks = calloc(num_threads, sizeof(*pm.chunks));
+	size_t size = end - p;
+	for (int t = 0; t < num_threads; t++) {
+		struct map_chunk *ch = &pm.chunks[t];
+		ch->shared = &pm;
+		ch->thread = t;
+		ch->start = t == 0 ? p : pm.chunks[t - 1].end;
+		ch->end = p + size / num_threads * (t + 1);
+		if (t == num_threads - 1) {
+			ch->end = end;
+		}
+		// move the cut to the start of the next line
+		while (ch->end < end && ch->end > ch->start
+		       && ch->end[-1] != '\n') {
+			ch->end++;
+		}
+		if (ch->end < ch->start) {
+			ch->end = ch->start;
+		}
+		ch->parts = calloc(num_threads, sizeof(*ch->parts));
+		ch->first_count = -1;
+		ch->last_count = -1;
+	}
+	run_threads(&pm, tokenize_chunk);
+
+	// the statements of the chunks, taken in file order
+	int num_tokens = 0;
+	int max_nodes = -1;
+	for (int t = 0; t < num_threads; t++) {
+		struct map_chunk *ch = &pm.chunks[t];
+		ch->offset = num_tokens;
+		num_tokens += ch->num_tokens;
+		if (ch->first_count >= 0 && max_nodes < 0) {
+			max_nodes = node_hint(ch->first_count, size);
+		}
+		if (ch->last_count >= 0) {
+			stats->declared_edges = ch->last_count;
+		}
+		for (int k = 0; k < ch->bad.count; k++) {
+			report_bad(ch->start + ch->bad.items[k], end);
+		}
+		stats->bad_lines += ch->bad.count;
+	}
+	stats->edges = num_tokens / 2;
+
+	pm.first = malloc((num_tokens + 1) * sizeof(*pm.first));
+	pm.nodes = malloc((num_tokens + 1) * sizeof(*pm.nodes));
+	run_threads(&pm, resolve_partition);
+
+	graph *g = new_graph(undirected, max_nodes < 0 ? 0 : max_nodes);
+	for (int t = 0; t < num_threads; t++) {
+		const struct map_chunk *ch = &pm.chunks[t];
+		for (int k = 0; k < ch->num_tokens; k++) {
+			int i = ch->offset + k;
+			if (pm.first[i] == i) {
+				pm.nodes[i] = graph_intern_node(g,
+					ch->tokens[k].name, ch->tokens[k].len);
+			}
+		}
+	}
+	run_threads(&pm, spread_nodes);
+	for (int t = 0; t < num_threads; t++) {
+		const struct map_chunk *ch = &pm.chunks[t];
+		for (int k = 0; k < ch->weights.count; k++) {
+			int i = ch->offset + 2 * k;
+			graph_insert_weighted_edge(g, pm.nodes[i],
+						   pm.nodes[i + 1],
+						   ch->weights.items[k]);
+		}
+	}
+
+	for (int t = 0; t < num_threads; t++) {
+		struct map_chunk *ch = &pm.chunks[t];
+		for (int u = 0; u < num_threads; u++) {
+			free(ch->parts[u].items);
+		}
+		free(ch->parts);
+		free(ch->tokens);
+		free(ch->bad.items);
+		free(ch->weights.items);
+	}
+	free(pm.chunks);
+	free(pm.first);
+	free(pm.nodes);
+	return g;
+}
+
+/**
+ * map_load() - Build a graph from a map file.
+ * @path: Name of the map file.
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @num_threads: Number of threads to parse with, 1 or less parses
+ * without threads.
+ * @stats: Filled in with what the file contained.
+ *
+ * Returns: The new graph, or NULL if the file could not be read.
+ */
+graph *map_load(const char *path, bool undirected, int num_threads,
+		map_stats *stats)
+{
+	map_file f;
+	if (!open_map(path, &f)) {
+		return NULL;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	// small files are not worth starting threads for
+	if (num_threads > (int)(f.size / MIN_CHUNK)) {
+		num_threads = f.size / MIN_CHUNK;
+	}
+	graph *g;
+	if (num_threads > 1) {
+		g = parse_map_parallel(f.data, f.data + f.size, undirected,
+				       num_threads, stats);
+	} else {
+		g = parse_map(f.data, f.data + f.size, undirected, stats);
+	}
+	close_map(&f);
+	return g;
+}
@@ -0,0 +1,80 @@
+#ifndef __MAP_H
+#define __MAP_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include "graph.h"
+
+/*
+ * Declaration of a loader for map files. A map file holds one item per
+ * line:
+ *
+ *   # comment			ignored
+ *   <number>			the number of edges of the map
+ *   <origin> <destination> [weight]
+ *				an edge, anything after it is ignored
+ *
+ * Blank lines are ignored. The number must start in the first column,
+ * and a number larger than MAP_COUNT_MAX makes the line a bad one.
+ * The weight of an edge, e.g. a distance, is a whole number of at most
+ * MAP_WEIGHT_MAX. An edge without one, or with anything else in its
+ * place, has weight 1.
+ * Node names are at most MAP_NAME_MAX characters long, a longer name
+ * is split after MAP_NAME_MAX characters the way scanf("%40s") splits
+ * it.
+ *
+ * The file is memory-mapped and tokenized in place, and the names are
+ * passed as slices to graph_intern_node(), so no line is copied. A large
+ * file can be parsed by several threads, which gives the same graph,
+ * with the same node ids and edge order, as parsing it with one.
+ */
+
+// Longest node name of a map.
+#define MAP_NAME_MAX 40
+
+// Largest edge weight of a map.
+#define MAP_WEIGHT_MAX 1000000000
+
+// Largest number of edges a map can declare, the graph is sized for
+// twice as many nodes.
+#define MAP_COUNT_MAX (INT_MAX / 4)
+
+// ==========PUBLIC DATA TYPES============
+
+// What a map file contained.
+typedef struct {
+	int declared_edges;	// Number of edges stated by the file, or 0.
+	int edges;		// Number of edges inserted into the graph.
+	int bad_lines;		// Lines that were neither comments nor edges.
+} map_stats;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * map_load() - Build a graph from a map file.
+ * @path: Name of the map file.
+ * @undirected: If true, the graph is created by graph_empty_undirected().
+ * @num_threads: Number of threads to parse with, 1 or less parses
+ * without threads.
+ * @stats: Filled in with what the file contained.
+ *
+ * With threads, the file is cut into chunks at line boundaries and the
+ * chunks are tokenized in parallel. The names are then resolved to
+ * their first occurrence in parallel, one hash partition per thread,
+ * and the nodes and edges are inserted in file order. Files too small
+ * to share out are parsed without threads.
+ *
+ * The graph is sized by the number of edges of the file. Each bad line
+ * is reported on stderr and skipped. It is up to the caller to check
+ * that the number of edges matches the stated one.
+ *
+ * Files that cannot be memory-mapped, such as pipes, are read into
+ * memory in one piece instead.
+ *
+ * Returns: The new graph, or NULL if the file could not be read. Note:
+ * The graph must be graph_kill()-ed after use.
+ */
+graph *map_load(const char *path, bool undirected, int num_threads,
+		map_stats *stats);
+
+#endif
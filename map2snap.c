@@ -0,0 +1,65 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "graph.h"
+#include "map.h"
+
+/*
+ * Conversion of a map file into a binary snapshot that is_connected can
+ * start from without parsing.
+ *
+ * Usage: map2snap [-t threads] <map file> <snapshot file>
+ */
+
+/**
+ * usage() - Print how the program is run and exit.
+ * @name: Name of the program.
+ *
+ * Returns: Does not return.
+ */
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-t threads] <map file> <snapshot file>\n",
+		name);
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+	int opt;
+	while ((opt = getopt(argc, argv, "t:")) != -1) {
+		if (opt != 't' || (threads = atoi(optarg)) < 1) {
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 2) {
+		usage(argv[0]);
+	}
+
+	map_stats stats;
+	graph *g = map_load(argv[optind], false, threads, &stats);
+	if (g == NULL) {
+		fprintf(stderr, "File can not be read\n");
+		return EXIT_FAILURE;
+	}
+	// a snapshot is only made of a map that holds what it declares
+	if (stats.edges != stats.declared_edges) {
+		fprintf(stderr, "inserted %d edges when the needes to be %d "
+			"edges\n", stats.edges, stats.declared_edges);
+		graph_kill(g);
+		return EXIT_FAILURE;
+	}
+
+	if (!graph_save_binary(g, argv[optind + 1])) {
+		fprintf(stderr, "File can not be written\n");
+		graph_kill(g);
+		return EXIT_FAILURE;
+	}
+	printf("%s: %d edges\n", argv[optind + 1], stats.edges);
+	graph_kill(g);
+	return 0;
+}
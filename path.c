@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "path.h"
+
+/*
+ * Implementation of breadth-first path finding with reusable parent
+ * arrays on a CSR snapshot.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * A node has been reached by the current query when its stamp equals
+ * the query number, parents[v] is then the node v was reached from.
+ */
+struct path_finder {
+	const csr_graph *c;
+	int *queue;
+	int *parents;
+	unsigned int *stamp;
+	unsigned int query;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * path_finder_empty() - Create a path finder for a snapshot.
+ * @c: Snapshot to search.
+ *
+ * Returns: A pointer to the new path finder.
+ */
+path_finder *path_finder_empty(const csr_graph *c)
+{
+	path_finder *p = malloc(sizeof(*p));
+	p->c = c;
+	p->queue = malloc((c->num_nodes + 1) * sizeof(*p->queue));
+	p->parents = malloc((c->num_nodes + 1) * sizeof(*p->parents));
+	p->stamp = calloc(c->num_nodes + 1, sizeof(*p->stamp));
+	p->query = 0;
+	return p;
+}
+
+/**
+ * path_finder_find() - Find a path with the fewest edges between two
+ *			nodes.
+ * @p: Path finder to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ * @counters: If not NULL, the work of the search is added to it.
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int path_finder_find(path_finder *p, int src, int dest, int *route,
+		     query_counters *counters)
+{
+	const csr_graph *c = p->c;
+	// a new query number makes all nodes unreached at once
+	if (++p->query == 0) {
+		memset(p->stamp, 0, c->num_nodes * sizeof(*p->stamp));
+		p->query = 1;
+	}
+
+	// The source is expanded first and never queued again, but dest is
+	// tested before the stamp, so a cycle back to src is still found.
+	p->stamp[src] = p->query;
+	int head = 0;
+	int tail = 0;
+	int current = src;
+	long edges = 0;
+	int peak = 0;
+	int length = 0;
+	for (;;) {
+		for (int k = c->offsets[current]; k < c->offsets[current + 1];
+		     k++) {
+			int v = c->targets[k];
+			edges++;
+			if (v == dest) {
+				p->parents[v] = current;
+				length = path_unwind(p->parents, src, dest, route);
+				break;
+			}
+			if (p->stamp[v] != p->query) {
+				p->stamp[v] = p->query;
+				p->parents[v] = current;
+				p->queue[tail++] = v;
+			}
+		}
+		if (tail - head > peak) {
+			peak = tail - head;
+		}
+		if (length > 0 || head == tail) {
+			break;
+		}
+		current = p->queue[head++];
+	}
+
+	if (counters != NULL) {
+		counters->dequeued += head + 1;
+		counters->scanned += edges;
+		if (peak > counters->peak_queue) {
+			counters->peak_queue = peak;
+		}
+	}
+	return length;
+}
+
+/**
+ * path_unwind() - Read a route back from the parents of a search.
+ * @parents: Parent id of each node reached by the search.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ *
+ * Returns: The number of nodes of the route.
+ */
+int path_unwind(const int *parents, int src, int dest, int *route)
+{
+	// count the edges first, so the route is written in order in place
+	int edges = 1;
+	for (int v = parents[dest]; v != src; v = parents[v]) {
+		edges++;
+	}
+	route[edges] = dest;
+	int v = parents[dest];
+	for (int i = edges - 1; i > 0; i--) {
+		route[i] = v;
+		v = parents[v];
+	}
+	route[0] = src;
+	return edges + 1;
+}
+
+/**
+ * path_finder_kill() - Destroy a given path finder.
+ * @p: Path finder to destroy.
+ *
+ * Returns: Nothing.
+ */
+void path_finder_kill(path_finder *p)
+{
+	free(p->queue);
+	free(p->parents);
+	free(p->stamp);
+	free(p);
+}
@@ -0,0 +1,75 @@
+#ifndef __PATH_H
+#define __PATH_H
+
+#include "csr.h"
+#include "query_stats.h"
+
+/*
+ * Declaration of a path finder for CSR snapshots. A breadth-first search
+ * records the parent id of every node it reaches, and the hops from the
+ * origin to the destination are then read back from the parents.
+ *
+ * The queue and parent arrays are allocated once by path_finder_empty()
+ * and stamped with the query that wrote them, so a query allocates
+ * nothing and does not clear them. The caller supplies the array that
+ * receives the route, num_nodes + 1 ids is always enough.
+ *
+ * After use, the function path_finder_kill() must be called to
+ * de-allocate the dynamic memory used by the path finder. The path
+ * finder does not own the snapshot, which must outlive it.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Path finder type.
+typedef struct path_finder path_finder;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * path_finder_empty() - Create a path finder for a snapshot.
+ * @c: Snapshot to search.
+ *
+ * Returns: A pointer to the new path finder.
+ */
+path_finder *path_finder_empty(const csr_graph *c);
+
+/**
+ * path_finder_find() - Find a path with the fewest edges between two
+ *			nodes.
+ * @p: Path finder to search with.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ * @counters: If not NULL, the work of the search is added to it as by
+ * csr_find_path().
+ *
+ * Finds a path exactly when csr_find_path() does, so a path has at least
+ * one edge and the route from a node to itself is a shortest cycle.
+ *
+ * Returns: The number of nodes of the route, or 0 if there is no path.
+ */
+int path_finder_find(path_finder *p, int src, int dest, int *route,
+		     query_counters *counters);
+
+/**
+ * path_unwind() - Read a route back from the parents of a search.
+ * @parents: Parent id of each node reached by the search, where
+ * parents[dest] is the node the path reached dest from.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ * @route: Filled in with the ids of the path, src first and dest last.
+ *
+ * Returns: The number of nodes of the route.
+ */
+int path_unwind(const int *parents, int src, int dest, int *route);
+
+/**
+ * path_finder_kill() - Destroy a given path finder.
+ * @p: Path finder to destroy.
+ *
+ * Returns: Nothing.
+ */
+void path_finder_kill(path_finder *p);
+
+#endif
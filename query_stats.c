@@ -0,0 +1,279 @@
+#include <stdlib.h>
+
+#include "query_stats.h"
+
+/*
+ * Implementation of lock-free, sharded statistics over reachability
+ * queries.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+// Values below LINEAR have a bucket each.
+#define LINEAR (1L << QUERY_STATS_PRECISION)
+
+// Buckets per power of two above LINEAR.
+#define HALF (LINEAR / 2)
+
+// Enough buckets for every positive long.
+#define NUM_BUCKETS (LINEAR + (63 - QUERY_STATS_PRECISION) * HALF)
+
+/*
+ * Statistics of the queries of one thread. Only its own thread writes a
+ * shard, so the fields are updated by atomic loads and stores instead
+ * of read-modify-write instructions. The padding keeps the hot fields
+ * of neighbouring shards on separate cache lines.
+ */
+typedef struct {
+	long queries;
+	query_counters total;
+	query_counters max;
+	int worst_src;
+	int worst_dest;
+	long buckets[NUM_BUCKETS];
+	char pad[64];
+} stats_shard;
+
+struct query_stats {
+	stats_shard *shards;
+	int num_shards;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * bucket_of() - Return the histogram bucket of a latency.
+ * @nanos: Latency in nanoseconds.
+ *
+ * Returns: Index of the bucket.
+ */
+static int bucket_of(long nanos)
+{
+	if (nanos < LINEAR) {
+		return nanos < 0 ? 0 : nanos;
+	}
+	int shift = 63 - __builtin_clzl(nanos) - QUERY_STATS_PRECISION + 1;
+	return LINEAR + (shift - 1) * HALF + ((nanos >> shift) - HALF);
+}
+
+/**
+ * bucket_max() - Return the largest latency of a histogram bucket.
+ * @b: Index of the bucket.
+ *
+ * Returns: The latency in nanoseconds.
+ */
+static long bucket_max(int b)
+{
+	if (b < LINEAR) {
+		return b;
+	}
+	int shift = (b - LINEAR) / HALF + 1;
+	long low = (HALF + (b - LINEAR) % HALF) << shift;
+	return low + (1L << shift) - 1;
+}
+
+/**
+ * add() - Add to a field of the shard of the calling thread.
+ * @field: Field to update.
+ * @value: Value to add.
+ *
+ * Returns: Nothing.
+ */
+static void add(long *field, long value)
+{
+	long old = __atomic_load_n(field, __ATOMIC_RELAXED);
+	__atomic_store_n(field, old + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * raise_to() - Raise a field of the shard of the calling thread to a
+ *		value if it is smaller.
+ * @field: Field to update.
+ * @value: New value.
+ *
+ * Returns: True if the field was raised, otherwise false.
+ */
+static bool raise_to(long *field, long value)
+{
+	if (__atomic_load_n(field, __ATOMIC_RELAXED) >= value) {
+		return false;
+	}
+	__atomic_store_n(field, value, __ATOMIC_RELAXED);
+	return true;
+}
+
+/**
+ * load() - Read a field of any shard.
+ * @field: Field to read.
+ *
+ * Returns: The value of the field.
+ */
+static long load(const long *field)
+{
+	return __atomic_load_n(field, __ATOMIC_RELAXED);
+}
+
+/**
+ * merge_counters() - Merge the counters of a shard into a summary.
+ * @to: Counters of the summary.
+ * @from: Counters of the shard.
+ * @take_max: If true, keep the larger values, otherwise add them.
+ *
+ * Returns: Nothing.
+ */
+static void merge_counters(query_counters *to, const query_counters *from,
+			   bool take_max)
+{
+	long *dst[] = {&to->dequeued, &to->scanned, &to->peak_queue,
+		       &to->allocations, &to->nanos};
+	const long *src[] = {&from->dequeued, &from->scanned,
+			     &from->peak_queue, &from->allocations,
+			     &from->nanos};
+	for (int i = 0; i < (int)(sizeof(dst) / sizeof(dst[0])); i++) {
+		long v = load(src[i]);
+		if (!take_max) {
+			*dst[i] += v;
+		} else if (v > *dst[i]) {
+			*dst[i] = v;
+		}
+	}
+}
+
+/**
+ * query_stats_empty() - Create empty statistics.
+ * @num_shards: Number of threads that record at the same time, at
+ * least 1.
+ *
+ * Returns: A pointer to the new statistics.
+ */
+query_stats *query_stats_empty(int num_shards)
+{
+	query_stats *s = malloc(sizeof(*s));
+	s->shards = calloc(num_shards, sizeof(*s->shards));
+	s->num_shards = num_shards;
+	for (int i = 0; i < num_shards; i++) {
+		s->shards[i].worst_src = -1;
+		s->shards[i].worst_dest = -1;
+	}
+	return s;
+}
+
+/**
+ * query_stats_record() - Record the counters of a query.
+ * @s: Statistics to update.
+ * @shard: Shard of the calling thread, 0..num_shards-1.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @q: Counters of the query.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_record(query_stats *s, int shard, int src, int dest,
+			const query_counters *q)
+{
+	stats_shard *sh = &s->shards[shard];
+	add(&sh->total.dequeued, q->dequeued);
+	add(&sh->total.scanned, q->scanned);
+	add(&sh->total.peak_queue, q->peak_queue);
+	add(&sh->total.allocations, q->allocations);
+	add(&sh->total.nanos, q->nanos);
+	raise_to(&sh->max.dequeued, q->dequeued);
+	raise_to(&sh->max.scanned, q->scanned);
+	raise_to(&sh->max.peak_queue, q->peak_queue);
+	raise_to(&sh->max.allocations, q->allocations);
+	if (raise_to(&sh->max.nanos, q->nanos)) {
+		__atomic_store_n(&sh->worst_src, src, __ATOMIC_RELAXED);
+		__atomic_store_n(&sh->worst_dest, dest, __ATOMIC_RELAXED);
+	}
+	add(&sh->buckets[bucket_of(q->nanos)], 1);
+	add(&sh->queries, 1);
+}
+
+/**
+ * query_stats_summary() - Summarize the recorded queries.
+ * @s: Statistics to inspect.
+ * @sum: Filled in with the merged shards.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_summary(const query_stats *s, query_summary *sum)
+{
+	query_summary zero = {0};
+	*sum = zero;
+	sum->worst_src = -1;
+	sum->worst_dest = -1;
+	long worst = -1;
+
+	for (int i = 0; i < s->num_shards; i++) {
+		const stats_shard *sh = &s->shards[i];
+		merge_counters(&sum->total, &sh->total, false);
+		merge_counters(&sum->max, &sh->max, true);
+		sum->queries += load(&sh->queries);
+		if (load(&sh->max.nanos) > worst) {
+			worst = load(&sh->max.nanos);
+			sum->worst_src = __atomic_load_n(&sh->worst_src,
+							 __ATOMIC_RELAXED);
+			sum->worst_dest = __atomic_load_n(&sh->worst_dest,
+							  __ATOMIC_RELAXED);
+		}
+	}
+	long *percentiles[] = {&sum->p50, &sum->p90, &sum->p99, &sum->p999};
+	double ps[] = {50, 90, 99, 99.9};
+	for (int i = 0; i < 4; i++) {
+		// a bucket bound may lie above the slowest query itself
+		*percentiles[i] = query_stats_percentile(s, ps[i]);
+		if (*percentiles[i] > sum->max.nanos) {
+			*percentiles[i] = sum->max.nanos;
+		}
+	}
+}
+
+/**
+ * query_stats_percentile() - Return a latency percentile.
+ * @s: Statistics to inspect.
+ * @p: Percentile, 0 to 100.
+ *
+ * Returns: The largest latency in nanoseconds of the histogram bucket
+ * that holds the percentile, or 0 if nothing was recorded.
+ */
+long query_stats_percentile(const query_stats *s, double p)
+{
+	long *merged = calloc(NUM_BUCKETS, sizeof(*merged));
+	long count = 0;
+	for (int i = 0; i < s->num_shards; i++) {
+		for (int b = 0; b < NUM_BUCKETS; b++) {
+			long n = load(&s->shards[i].buckets[b]);
+			merged[b] += n;
+			count += n;
+		}
+	}
+
+	// the rank of the percentile among the sorted latencies, from 1
+	long rank = (long)(p / 100 * count + 0.999999);
+	if (rank < 1) {
+		rank = 1;
+	}
+	long value = 0;
+	long seen = 0;
+	for (int b = 0; b < NUM_BUCKETS && count > 0; b++) {
+		seen += merged[b];
+		if (seen >= rank) {
+			value = bucket_max(b);
+			break;
+		}
+	}
+	free(merged);
+	return value;
+}
+
+/**
+ * query_stats_kill() - Destroy given statistics.
+ * @s: Statistics to destroy.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_kill(query_stats *s)
+{
+	free(s->shards);
+	free(s);
+}
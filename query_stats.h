@@ -0,0 +1,112 @@
+#ifndef __QUERY_STATS_H
+#define __QUERY_STATS_H
+
+#include <stdbool.h>
+
+/*
+ * Declaration of statistics over reachability queries. Each query is
+ * described by its counters: the work done by its search and its wall
+ * time. The statistics keep the sums and maxima of the counters, the
+ * origin/destination pair of the slowest query and a latency histogram.
+ *
+ * The histogram is HDR-style: values below 2^QUERY_STATS_PRECISION
+ * nanoseconds have a bucket each, larger ones share a bucket with the
+ * values that agree in their QUERY_STATS_PRECISION leading bits, so a
+ * percentile is accurate to about 1 in 2^(QUERY_STATS_PRECISION-1)
+ * whatever its size.
+ *
+ * The statistics are split into shards. Every thread records into a
+ * shard of its own with plain atomic stores, so recording takes no
+ * lock and shards do not share cache lines, and the shards are merged
+ * when the statistics are read.
+ *
+ * After use, the function query_stats_kill() must be called to
+ * de-allocate the dynamic memory used by the statistics.
+ */
+
+// Leading bits of a latency that select its histogram bucket.
+#define QUERY_STATS_PRECISION 5
+
+// ==========PUBLIC DATA TYPES============
+
+// Statistics type.
+typedef struct query_stats query_stats;
+
+// What one query cost. Searches add to the counters they know about.
+typedef struct {
+	long dequeued;		// Nodes taken from the queue.
+	long scanned;		// Edges looked at.
+	long peak_queue;	// Largest number of nodes queued at once.
+	long allocations;	// Blocks of memory allocated.
+	long nanos;		// Wall time in nanoseconds.
+} query_counters;
+
+// Summary of the recorded queries.
+typedef struct {
+	long queries;		// Number of recorded queries.
+	query_counters total;	// Sum of each counter.
+	query_counters max;	// Largest value of each counter.
+	int worst_src;		// Pair of the slowest query, -1 if none.
+	int worst_dest;
+	long p50;		// Latency percentiles in nanoseconds.
+	long p90;
+	long p99;
+	long p999;
+} query_summary;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * query_stats_empty() - Create empty statistics.
+ * @num_shards: Number of threads that record at the same time, at
+ * least 1.
+ *
+ * Returns: A pointer to the new statistics.
+ */
+query_stats *query_stats_empty(int num_shards);
+
+/**
+ * query_stats_record() - Record the counters of a query.
+ * @s: Statistics to update.
+ * @shard: Shard of the calling thread, 0..num_shards-1. Two threads
+ * must not record into the same shard at the same time.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @q: Counters of the query.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_record(query_stats *s, int shard, int src, int dest,
+			const query_counters *q);
+
+/**
+ * query_stats_summary() - Summarize the recorded queries.
+ * @s: Statistics to inspect.
+ * @sum: Filled in with the merged shards.
+ *
+ * May run while other threads record, the summary then holds some
+ * subset of their latest queries.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_summary(const query_stats *s, query_summary *sum);
+
+/**
+ * query_stats_percentile() - Return a latency percentile.
+ * @s: Statistics to inspect.
+ * @p: Percentile, 0 to 100.
+ *
+ * Returns: The largest latency in nanoseconds of the histogram bucket
+ * that holds the percentile, or 0 if nothing was recorded.
+ */
+long query_stats_percentile(const query_stats *s, double p);
+
+/**
+ * query_stats_kill() - Destroy given statistics.
+ * @s: Statistics to destroy.
+ *
+ * Returns: Nothing.
+ */
+void query_stats_kill(query_stats *s);
+
+#endif
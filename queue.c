@@ -1,7 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "queue.h"
-#include "list.h"
 
 /*
  * Implementation of a generic queue for the "Datastructures and
@@ -15,21 +14,54 @@
  *
  * Version information:
  *   2018-01-28: v1.0, first public version.
+ *   2026-10-17: v1.1, ring buffer instead of list, queue_with_capacity().
  */
 
 // ===========INTERNAL DATA TYPES============
 
 /*
- * The queue is implemented using the list abstract datatype. Almost
- * everything is done by the list.
+ * The queue is implemented as a growable ring buffer. The elements are
+ * stored in elements[head], elements[head+1], ... (modulo capacity).
+ * The capacity is always a power of two and is doubled when the buffer
+ * is full, so enqueue and dequeue do not allocate memory in the common
+ * case.
  */
 
 struct queue {
-	list *elements;
+	void **elements;
+	int capacity;
+	int head;
+	int size;
+	int allocations;	// Blocks allocated, head and buffers.
+	free_function free_func;
 };
 
+// Capacity of a queue created by queue_empty().
+#define DEFAULT_CAPACITY 16
+
 // ===========INTERNAL FUNCTION IMPLEMENTATIONS============
 
+/**
+ * queue_grow() - Double the capacity of a queue.
+ * @q: Queue to manipulate.
+ *
+ * Returns: Nothing.
+ */
+static void queue_grow(queue *q)
+{
+	void **elements = malloc(2 * q->capacity * sizeof(*elements));
+
+	// Copy the elements in order to the start of the new buffer.
+	for (int i = 0; i < q->size; i++) {
+		elements[i] = q->elements[(q->head + i) & (q->capacity - 1)];
+	}
+	free(q->elements);
+	q->elements = elements;
+	q->capacity *= 2;
+	q->head = 0;
+	q->allocations++;
+}
+
 /**
  * queue_empty() - Create an empty queue.
  * @free_func: A pointer to a function (or NULL) to be called to
@@ -38,11 +70,32 @@ struct queue {
  * Returns: A pointer to the new queue.
  */
 queue *queue_empty(free_function free_func)
+{
+	return queue_with_capacity(free_func, DEFAULT_CAPACITY);
+}
+
+/**
+ * queue_with_capacity() - Create an empty queue with room for a given
+ *			   number of elements.
+ * @free_func: A pointer to a function (or NULL) to be called to
+ *	       de-allocate memory on remove/kill.
+ * @capacity: Number of elements the queue can hold before it has to grow.
+ *
+ * Returns: A pointer to the new queue.
+ */
+queue *queue_with_capacity(free_function free_func, int capacity)
 {
 	// Allocate the queue head.
 	queue *q=calloc(1, sizeof(*q));
-	// Create an empty list.
-	q->elements=list_empty(free_func);
+
+	// Round the capacity up to a power of two.
+	q->capacity = 1;
+	while (q->capacity < capacity) {
+		q->capacity *= 2;
+	}
+	q->elements = malloc(q->capacity * sizeof(*q->elements));
+	q->allocations = 2;
+	q->free_func = free_func;
 
 	return q;
 }
@@ -55,7 +108,7 @@ queue *queue_empty(free_function free_func)
  */
 bool queue_is_empty(const queue *q)
 {
-	return list_is_empty(q->elements);
+	return q->size == 0;
 }
 
 /**
@@ -67,7 +120,11 @@ bool queue_is_empty(const queue *q)
  */
 queue *queue_enqueue(queue *q, void *v)
 {
-	list_insert(q->elements, v, list_end(q->elements));
+	if (q->size == q->capacity) {
+		queue_grow(q);
+	}
+	q->elements[(q->head + q->size) & (q->capacity - 1)] = v;
+	q->size++;
 	return q;
 }
 
@@ -81,7 +138,12 @@ queue *queue_enqueue(queue *q, void *v)
  */
 queue *queue_dequeue(queue *q)
 {
-	list_remove(q->elements, list_first(q->elements));
+	// Call free_func if registered.
+	if (q->free_func != NULL) {
+		q->free_func(q->elements[q->head]);
+	}
+	q->head = (q->head + 1) & (q->capacity - 1);
+	q->size--;
 	return q;
 }
 
@@ -94,7 +156,19 @@ queue *queue_dequeue(queue *q)
  */
 void *queue_front(const queue *q)
 {
-	return list_inspect(q->elements, list_first(q->elements));
+	return q->elements[q->head];
+}
+
+/**
+ * queue_allocations() - Return the number of blocks of memory the queue
+ *			 has allocated.
+ * @q: Queue to inspect.
+ *
+ * Returns: The number of allocations, the head and buffers of the queue.
+ */
+int queue_allocations(const queue *q)
+{
+	return q->allocations;
 }
 
 /**
@@ -109,7 +183,10 @@ void *queue_front(const queue *q)
  */
 void queue_kill(queue *q)
 {
-	list_kill(q->elements);
+	while (!queue_is_empty(q)) {
+		queue_dequeue(q);
+	}
+	free(q->elements);
 	free(q);
 }
 
@@ -126,11 +203,9 @@ void queue_kill(queue *q)
 void queue_print(const queue *q, inspect_callback print_func)
 {
 	printf("{ ");
-	list_pos pos = list_first(q->elements);
-	while (pos != list_end(q->elements)) {
-		print_func(list_inspect(q->elements, pos));
-		pos = list_next(q->elements, pos);
-		if (pos != list_end(q->elements)) {
+	for (int i = 0; i < q->size; i++) {
+		print_func(q->elements[(q->head + i) & (q->capacity - 1)]);
+		if (i + 1 < q->size) {
 			printf(", ");
 		}
 	}
@@ -21,6 +21,8 @@
  *
  * Version information:
  *   2018-01-28: v1.0, first public version.
+ *   2026-10-17: v1.1, added queue_with_capacity().
+ *   2026-10-17: v1.2, added queue_allocations().
  */
 
 // ==========PUBLIC DATA TYPES============
@@ -39,6 +41,19 @@ typedef struct queue queue;
  */
 queue *queue_empty(free_function free_func);
 
+/**
+ * queue_with_capacity() - Create an empty queue with room for a given
+ *			   number of elements.
+ * @free_func: A pointer to a function (or NULL) to be called to
+ *	       de-allocate memory on remove/kill.
+ * @capacity: Number of elements the queue can hold before it has to grow.
+ *
+ * The queue still grows as needed, the capacity is only a hint.
+ *
+ * Returns: A pointer to the new queue.
+ */
+queue *queue_with_capacity(free_function free_func, int capacity);
+
 /**
  * queue_is_empty() - Check if a queue is empty.
  * @q: Queue to check.
@@ -75,6 +90,18 @@ queue *queue_dequeue(queue *q);
  */
 void *queue_front(const queue *q);
 
+/**
+ * queue_allocations() - Return the number of blocks of memory the queue
+ *			 has allocated.
+ * @q: Queue to inspect.
+ *
+ * Counts the queue head and every buffer, also those freed when the
+ * queue grew.
+ *
+ * Returns: The number of allocations.
+ */
+int queue_allocations(const queue *q);
+
 /**
  * queue_kill() - Destroy a given queue.
  * @q: Queue to destroy.
@@ -0,0 +1,247 @@
+#include <stdlib.h>
+
+#include "reach_cache.h"
+
+/*
+ * Implementation of a bounded LRU cache of reachability answers.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * The entries live in one array of capacity entries. The used entries
+ * form a doubly linked list in order of use, most recent first, and
+ * each hash bucket chains the entries of the pairs that hash to it.
+ * Links are array indices, -1 ends a list.
+ */
+typedef struct {
+	int src;
+	int dest;
+	unsigned int generation;
+	bool reachable;
+	int prev;		// Neighbours in order of use.
+	int next;
+	int chain;		// Next entry of the same bucket.
+} entry;
+
+struct reach_cache {
+	entry *entries;
+	int capacity;
+	int count;
+	int first;		// Most recently used entry.
+	int last;		// Least recently used entry.
+	int *buckets;
+	unsigned int mask;	// Number of buckets - 1, a power of two.
+	long hits;
+	long misses;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * bucket_of() - Return the bucket of a pair.
+ * @c: Cache to inspect.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: Index of the bucket.
+ */
+static unsigned int bucket_of(const reach_cache *c, int src, int dest)
+{
+	unsigned int h = (unsigned int)src * 2654435761u;
+	h ^= (unsigned int)dest + 0x9e3779b9u + (h << 6) + (h >> 2);
+	return (h ^ (h >> 16)) & c->mask;
+}
+
+/**
+ * find_entry() - Find the entry of a pair.
+ * @c: Cache to inspect.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: Index of the entry, or -1 if the pair is not in the cache.
+ */
+static int find_entry(const reach_cache *c, int src, int dest)
+{
+	int i = c->buckets[bucket_of(c, src, dest)];
+	while (i >= 0 && (c->entries[i].src != src
+			  || c->entries[i].dest != dest)) {
+		i = c->entries[i].chain;
+	}
+	return i;
+}
+
+/**
+ * unlink_use() - Take an entry out of the list in order of use.
+ * @c: Cache to modify.
+ * @i: Index of the entry.
+ *
+ * Returns: Nothing.
+ */
+static void unlink_use(reach_cache *c, int i)
+{
+	entry *e = &c->entries[i];
+	if (e->prev >= 0) {
+		c->entries[e->prev].next = e->next;
+	} else {
+		c->first = e->next;
+	}
+	if (e->next >= 0) {
+		c->entries[e->next].prev = e->prev;
+	} else {
+		c->last = e->prev;
+	}
+}
+
+/**
+ * push_use() - Make an entry the most recently used one.
+ * @c: Cache to modify.
+ * @i: Index of the entry, not in the list in order of use.
+ *
+ * Returns: Nothing.
+ */
+static void push_use(reach_cache *c, int i)
+{
+	entry *e = &c->entries[i];
+	e->prev = -1;
+	e->next = c->first;
+	if (c->first >= 0) {
+		c->entries[c->first].prev = i;
+	} else {
+		c->last = i;
+	}
+	c->first = i;
+}
+
+/**
+ * unlink_chain() - Take an entry out of its bucket.
+ * @c: Cache to modify.
+ * @i: Index of the entry.
+ *
+ * Returns: Nothing.
+ */
+static void unlink_chain(reach_cache *c, int i)
+{
+	entry *e = &c->entries[i];
+	int *link = &c->buckets[bucket_of(c, e->src, e->dest)];
+	while (*link != i) {
+		link = &c->entries[*link].chain;
+	}
+	*link = e->chain;
+}
+
+/**
+ * reach_cache_empty() - Create an empty cache.
+ * @capacity: Maximum number of answers to keep, at least 1.
+ *
+ * Returns: A pointer to the new cache.
+ */
+reach_cache *reach_cache_empty(int capacity)
+{
+	reach_cache *c = calloc(1, sizeof(*c));
+	int num_buckets = 16;
+
+	// at most one entry per bucket on average when full
+	while (num_buckets < capacity) {
+		num_buckets *= 2;
+	}
+	c->entries = malloc(capacity * sizeof(*c->entries));
+	c->capacity = capacity;
+	c->first = -1;
+	c->last = -1;
+	c->buckets = malloc(num_buckets * sizeof(*c->buckets));
+	c->mask = num_buckets - 1;
+	for (int b = 0; b < num_buckets; b++) {
+		c->buckets[b] = -1;
+	}
+	return c;
+}
+
+/**
+ * reach_cache_lookup() - Look up the answer for a pair.
+ * @c: Cache to inspect.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @generation: Current generation of the graph.
+ * @reachable: Set to the cached answer on a hit.
+ *
+ * Returns: True on a hit, false if the pair has no answer of the given
+ * generation.
+ */
+bool reach_cache_lookup(reach_cache *c, int src, int dest,
+			unsigned int generation, bool *reachable)
+{
+	int i = find_entry(c, src, dest);
+	if (i < 0 || c->entries[i].generation != generation) {
+		c->misses++;
+		return false;
+	}
+	unlink_use(c, i);
+	push_use(c, i);
+	*reachable = c->entries[i].reachable;
+	c->hits++;
+	return true;
+}
+
+/**
+ * reach_cache_store() - Store the answer for a pair.
+ * @c: Cache to modify.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @generation: Generation of the graph the answer was computed on.
+ * @reachable: Answer to store.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_store(reach_cache *c, int src, int dest,
+		       unsigned int generation, bool reachable)
+{
+	int i = find_entry(c, src, dest);
+	if (i >= 0) {
+		unlink_use(c, i);
+	} else {
+		if (c->count < c->capacity) {
+			i = c->count++;
+		} else {
+			// reuse the least recently used entry
+			i = c->last;
+			unlink_use(c, i);
+			unlink_chain(c, i);
+		}
+		unsigned int b = bucket_of(c, src, dest);
+		c->entries[i].src = src;
+		c->entries[i].dest = dest;
+		c->entries[i].chain = c->buckets[b];
+		c->buckets[b] = i;
+	}
+	c->entries[i].generation = generation;
+	c->entries[i].reachable = reachable;
+	push_use(c, i);
+}
+
+/**
+ * reach_cache_counts() - Return the hit and miss counts of the lookups.
+ * @c: Cache to inspect.
+ * @hits: Set to the number of lookups that found an answer.
+ * @misses: Set to the number of lookups that did not.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_counts(const reach_cache *c, long *hits, long *misses)
+{
+	*hits = c->hits;
+	*misses = c->misses;
+}
+
+/**
+ * reach_cache_kill() - Destroy a given cache.
+ * @c: Cache to destroy.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_kill(reach_cache *c)
+{
+	free(c->entries);
+	free(c->buckets);
+	free(c);
+}
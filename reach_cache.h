@@ -0,0 +1,85 @@
+#ifndef __REACH_CACHE_H
+#define __REACH_CACHE_H
+
+#include <stdbool.h>
+
+/*
+ * Declaration of a bounded cache of reachability answers for
+ * origin/destination pairs of node ids. When the cache is full, the
+ * least recently used answer is dropped to make room for a new one.
+ *
+ * Every answer is stored with the generation of the graph it was
+ * computed on. A lookup with another generation treats the answer as
+ * missing, so bumping the generation on every change of the graph
+ * invalidates the whole cache in constant time.
+ *
+ * After use, the function reach_cache_kill() must be called to
+ * de-allocate the dynamic memory used by the cache.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Cache type.
+typedef struct reach_cache reach_cache;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * reach_cache_empty() - Create an empty cache.
+ * @capacity: Maximum number of answers to keep, at least 1.
+ *
+ * Returns: A pointer to the new cache.
+ */
+reach_cache *reach_cache_empty(int capacity);
+
+/**
+ * reach_cache_lookup() - Look up the answer for a pair.
+ * @c: Cache to inspect.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @generation: Current generation of the graph.
+ * @reachable: Set to the cached answer on a hit.
+ *
+ * A hit makes the answer the most recently used one.
+ *
+ * Returns: True on a hit, false if the pair has no answer of the given
+ * generation.
+ */
+bool reach_cache_lookup(reach_cache *c, int src, int dest,
+			unsigned int generation, bool *reachable);
+
+/**
+ * reach_cache_store() - Store the answer for a pair.
+ * @c: Cache to modify.
+ * @src: Id of the origin node.
+ * @dest: Id of the destination node.
+ * @generation: Generation of the graph the answer was computed on.
+ * @reachable: Answer to store.
+ *
+ * Replaces any earlier answer for the pair, otherwise drops the least
+ * recently used answer if the cache is full.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_store(reach_cache *c, int src, int dest,
+		       unsigned int generation, bool reachable);
+
+/**
+ * reach_cache_counts() - Return the hit and miss counts of the lookups.
+ * @c: Cache to inspect.
+ * @hits: Set to the number of lookups that found an answer.
+ * @misses: Set to the number of lookups that did not.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_counts(const reach_cache *c, long *hits, long *misses);
+
+/**
+ * reach_cache_kill() - Destroy a given cache.
+ * @c: Cache to destroy.
+ *
+ * Returns: Nothing.
+ */
+void reach_cache_kill(reach_cache *c);
+
+#endif
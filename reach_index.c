@@ -0,0 +1,478 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "reach_index.h"
+
+/*
+ * Implementation of a precomputed reachability index for CSR snapshots.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * The components are numbered in the order Tarjan's algorithm completes
+ * them. Every DAG edge therefore goes from a higher to a lower component
+ * number, and decreasing component number is a topological order.
+ *
+ * The labels of component x are stored at x*num_labels+t for label t.
+ * Component x can only reach component y if every label interval
+ * [low, rank] of x contains that of y, and if the topological level of x
+ * is lower than that of y.
+ */
+struct reach_index {
+	const csr_graph *c;
+	int num_comps;
+	int *comp;		// Component of each node.
+	bool *cyclic;		// Component has a path from a node to itself.
+	int *dag_offsets;	// Condensation DAG in CSR form.
+	int *dag_targets;
+	int *level;		// Longest path from a DAG root.
+	int num_labels;
+	int *low;		// Smallest post-order rank below each vertex.
+	int *rank;		// Post-order rank of each vertex.
+	// Scratch space of the fallback search.
+	unsigned int *stamp;
+	unsigned int epoch;
+	int *stack;
+	// Query counters.
+	long by_labels;
+	long by_search;
+};
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * find_components() - Find the strongly connected components of a
+ *		       snapshot with an iterative version of Tarjan's
+ *		       algorithm.
+ * @idx: Index to fill in. Sets comp, cyclic and num_comps.
+ *
+ * Returns: Nothing.
+ */
+static void find_components(reach_index *idx)
+{
+	const csr_graph *c = idx->c;
+	int n = c->num_nodes;
+	int *order = malloc((n + 1) * sizeof(*order));
+	int *low = malloc((n + 1) * sizeof(*low));
+	int *frames = malloc((n + 1) * sizeof(*frames));
+	int *edge = malloc((n + 1) * sizeof(*edge));
+	int *scc_stack = malloc((n + 1) * sizeof(*scc_stack));
+	bool *on_stack = calloc(n + 1, sizeof(*on_stack));
+	bool *self_loop = calloc(n + 1, sizeof(*self_loop));
+	int counter = 0;
+	int scc_top = 0;
+
+	idx->comp = malloc((n + 1) * sizeof(*idx->comp));
+	idx->cyclic = calloc(n + 1, sizeof(*idx->cyclic));
+	idx->num_comps = 0;
+	for (int v = 0; v < n; v++) {
+		order[v] = -1;
+	}
+
+	for (int s = 0; s < n; s++) {
+		if (order[s] >= 0) {
+			continue;
+		}
+		// The call stack holds the nodes being visited and the next
+		// edge to follow from each of them.
+		int top = 0;
+		frames[0] = s;
+		edge[0] = c->offsets[s];
+		order[s] = low[s] = counter++;
+		scc_stack[scc_top++] = s;
+		on_stack[s] = true;
+
+		while (top >= 0) {
+			int v = frames[top];
+			if (edge[top] < c->offsets[v + 1]) {
+				int w = c->targets[edge[top]++];
+				if (w == v) {
+					self_loop[v] = true;
+				}
+				if (order[w] < 0) {
+					// Descend to w.
+					order[w] = low[w] = counter++;
+					scc_stack[scc_top++] = w;
+					on_stack[w] = true;
+					top++;
+					frames[top] = w;
+					edge[top] = c->offsets[w];
+				} else if (on_stack[w] && order[w] < low[v]) {
+					low[v] = order[w];
+				}
+				continue;
+			}
+
+			// All edges of v are done; v may be a component root.
+			if (low[v] == order[v]) {
+				int x;
+				int size = 0;
+				bool cyclic = false;
+				do {
+					x = scc_stack[--scc_top];
+					on_stack[x] = false;
+					idx->comp[x] = idx->num_comps;
+					cyclic = cyclic || self_loop[x];
+					size++;
+				} while (x != v);
+				idx->cyclic[idx->num_comps++] = cyclic
+					|| size > 1;
+			}
+			top--;
+			if (top >= 0 && low[v] < low[frames[top]]) {
+				low[frames[top]] = low[v];
+			}
+		}
+	}
+
+	free(order);
+	free(low);
+	free(frames);
+	free(edge);
+	free(scc_stack);
+	free(on_stack);
+	free(self_loop);
+}
+
+/**
+ * build_dag() - Build the condensation DAG and its topological levels.
+ * @idx: Index to fill in. Sets dag_offsets, dag_targets and level.
+ *
+ * Returns: Nothing.
+ */
+static void build_dag(reach_index *idx)
+{
+	const csr_graph *c = idx->c;
+	int n = c->num_nodes;
+	int m = idx->num_comps;
+	int *members = malloc((n + 1) * sizeof(*members));
+	int *member_offsets = calloc(m + 1, sizeof(*member_offsets));
+	int *last_source = malloc((m + 1) * sizeof(*last_source));
+
+	// Sort the nodes by component.
+	for (int v = 0; v < n; v++) {
+		member_offsets[idx->comp[v] + 1]++;
+	}
+	for (int x = 0; x < m; x++) {
+		member_offsets[x + 1] += member_offsets[x];
+	}
+	int *fill = malloc((m + 1) * sizeof(*fill));
+	memcpy(fill, member_offsets, (m + 1) * sizeof(*fill));
+	for (int v = 0; v < n; v++) {
+		members[fill[idx->comp[v]]++] = v;
+	}
+	free(fill);
+
+	// Collect the distinct edges between components.
+	idx->dag_offsets = malloc((m + 1) * sizeof(*idx->dag_offsets));
+	idx->dag_targets = malloc((c->num_edges + 1)
+				  * sizeof(*idx->dag_targets));
+	for (int x = 0; x < m; x++) {
+		last_source[x] = -1;
+	}
+	int k = 0;
+	for (int x = 0; x < m; x++) {
+		idx->dag_offsets[x] = k;
+		for (int i = member_offsets[x]; i < member_offsets[x + 1];
+		     i++) {
+			int u = members[i];
+			for (int e = c->offsets[u]; e < c->offsets[u + 1]; e++) {
+				int y = idx->comp[c->targets[e]];
+				if (y != x && last_source[y] != x) {
+					last_source[y] = x;
+					idx->dag_targets[k++] = y;
+				}
+			}
+		}
+	}
+	idx->dag_offsets[m] = k;
+
+	// Decreasing component number is a topological order.
+	idx->level = calloc(m + 1, sizeof(*idx->level));
+	for (int x = m - 1; x >= 0; x--) {
+		for (int e = idx->dag_offsets[x]; e < idx->dag_offsets[x + 1];
+		     e++) {
+			int y = idx->dag_targets[e];
+			if (idx->level[y] < idx->level[x] + 1) {
+				idx->level[y] = idx->level[x] + 1;
+			}
+		}
+	}
+
+	free(members);
+	free(member_offsets);
+	free(last_source);
+}
+
+/**
+ * child() - Return the j:th child of a DAG vertex in the visiting order
+ *	     of a labeling traversal.
+ * @idx: Index to inspect.
+ * @x: DAG vertex.
+ * @j: Child number, 0..out-degree-1.
+ * @t: Traversal number.
+ *
+ * Each traversal starts at a different, pseudo-random child, so that
+ * the labels of the traversals differ.
+ *
+ * Returns: The child.
+ */
+static int child(const reach_index *idx, int x, int j, int t)
+{
+	int first = idx->dag_offsets[x];
+	int degree = idx->dag_offsets[x + 1] - first;
+	unsigned int start = ((unsigned int)x * 2654435761u
+			      + (unsigned int)t * 40503u) % degree;
+	return idx->dag_targets[first + (start + j) % degree];
+}
+
+/**
+ * build_labels() - Compute the GRAIL interval labels of the DAG.
+ * @idx: Index to fill in. Sets low and rank.
+ *
+ * Returns: Nothing.
+ */
+static void build_labels(reach_index *idx)
+{
+	int m = idx->num_comps;
+	int k = idx->num_labels;
+	int *frames = malloc((m + 1) * sizeof(*frames));
+	int *next_child = malloc((m + 1) * sizeof(*next_child));
+	int *roots = malloc((m + 1) * sizeof(*roots));
+	bool *has_parent = calloc(m + 1, sizeof(*has_parent));
+	bool *done = malloc((m + 1) * sizeof(*done));
+	int num_roots = 0;
+
+	idx->low = malloc(((long)m * k + 1) * sizeof(*idx->low));
+	idx->rank = malloc(((long)m * k + 1) * sizeof(*idx->rank));
+
+	for (int e = 0; e < idx->dag_offsets[m]; e++) {
+		has_parent[idx->dag_targets[e]] = true;
+	}
+	for (int x = 0; x < m; x++) {
+		if (!has_parent[x]) {
+			roots[num_roots++] = x;
+		}
+	}
+
+	for (int t = 0; t < k; t++) {
+		int rank = 0;
+		memset(done, 0, (m + 1) * sizeof(*done));
+		for (int r = 0; r < num_roots; r++) {
+			// Start from the roots in a different order each time.
+			int root = roots[(r + (long)t * num_roots / k)
+					 % num_roots];
+			int top = 0;
+			frames[0] = root;
+			next_child[0] = 0;
+			idx->low[(long)root * k + t] = m;
+
+			while (top >= 0) {
+				int x = frames[top];
+				int degree = idx->dag_offsets[x + 1]
+					- idx->dag_offsets[x];
+				long lx = (long)x * k + t;
+				if (next_child[top] < degree) {
+					int y = child(idx, x, next_child[top]++,
+						      t);
+					long ly = (long)y * k + t;
+					if (!done[y]) {
+						// Descend to y; a DAG has no
+						// back edges, so y is new.
+						done[y] = true;
+						idx->low[ly] = m;
+						top++;
+						frames[top] = y;
+						next_child[top] = 0;
+					} else if (idx->low[ly] < idx->low[lx]) {
+						idx->low[lx] = idx->low[ly];
+					}
+					continue;
+				}
+
+				// x is finished and gets the next rank.
+				done[x] = true;
+				idx->rank[lx] = rank++;
+				if (rank - 1 < idx->low[lx]) {
+					idx->low[lx] = rank - 1;
+				}
+				top--;
+				if (top >= 0) {
+					long lp = (long)frames[top] * k + t;
+					if (idx->low[lx] < idx->low[lp]) {
+						idx->low[lp] = idx->low[lx];
+					}
+				}
+			}
+		}
+	}
+
+	free(frames);
+	free(next_child);
+	free(roots);
+	free(has_parent);
+	free(done);
+}
+
+/**
+ * may_reach() - Check the labels of two DAG vertices.
+ * @idx: Index to inspect.
+ * @x: Source vertex.
+ * @y: Destination vertex, different from x.
+ *
+ * Returns: False if the labels prove that x cannot reach y, otherwise
+ *	    true.
+ */
+static bool may_reach(const reach_index *idx, int x, int y)
+{
+	if (idx->level[x] >= idx->level[y]) {
+		return false;
+	}
+	int k = idx->num_labels;
+	for (int t = 0; t < k; t++) {
+		long lx = (long)x * k + t;
+		long ly = (long)y * k + t;
+		if (idx->low[lx] > idx->low[ly]
+		    || idx->rank[ly] > idx->rank[lx]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * guided_search() - Depth-first search on the DAG pruned by the labels.
+ * @idx: Index to use.
+ * @x: Source vertex.
+ * @y: Destination vertex, different from x.
+ *
+ * Returns: True if x can reach y, otherwise false.
+ */
+static bool guided_search(reach_index *idx, int x, int y)
+{
+	// A new epoch makes all old stamps stale.
+	if (++idx->epoch == 0) {
+		memset(idx->stamp, 0, idx->num_comps * sizeof(*idx->stamp));
+		idx->epoch = 1;
+	}
+
+	int top = 0;
+	idx->stack[top++] = x;
+	while (top > 0) {
+		int u = idx->stack[--top];
+		for (int e = idx->dag_offsets[u]; e < idx->dag_offsets[u + 1];
+		     e++) {
+			int v = idx->dag_targets[e];
+			if (v == y) {
+				return true;
+			}
+			if (idx->stamp[v] == idx->epoch) {
+				continue;
+			}
+			idx->stamp[v] = idx->epoch;
+			if (may_reach(idx, v, y)) {
+				idx->stack[top++] = v;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * reach_index_build() - Build a reachability index for a snapshot.
+ * @c: Snapshot to index. Must outlive the index.
+ * @num_labels: Number of interval labels per DAG vertex, at least 1.
+ *
+ * Returns: A pointer to the new index.
+ */
+reach_index *reach_index_build(const csr_graph *c, int num_labels)
+{
+	reach_index *idx = calloc(1, sizeof(*idx));
+	idx->c = c;
+	idx->num_labels = num_labels > 0 ? num_labels : 1;
+
+	find_components(idx);
+	build_dag(idx);
+	build_labels(idx);
+
+	idx->stamp = calloc(idx->num_comps + 1, sizeof(*idx->stamp));
+	idx->stack = malloc((idx->num_comps + 1) * sizeof(*idx->stack));
+	return idx;
+}
+
+/**
+ * reach_index_query() - See if a path exists between two nodes.
+ * @idx: Index to use.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool reach_index_query(reach_index *idx, int src, int dest)
+{
+	int x = idx->comp[src];
+	int y = idx->comp[dest];
+
+	// Nodes of one component reach each other; a node only reaches
+	// itself if its component has a cycle.
+	if (x == y) {
+		idx->by_labels++;
+		return src != dest || idx->cyclic[x];
+	}
+	if (!may_reach(idx, x, y)) {
+		idx->by_labels++;
+		return false;
+	}
+	idx->by_search++;
+	return guided_search(idx, x, y);
+}
+
+/**
+ * reach_index_num_components() - Return the number of strongly connected
+ *				  components of the indexed snapshot.
+ * @idx: Index to inspect.
+ *
+ * Returns: The number of vertices of the condensation DAG.
+ */
+int reach_index_num_components(const reach_index *idx)
+{
+	return idx->num_comps;
+}
+
+/**
+ * reach_index_counts() - Return how the queries so far were answered.
+ * @idx: Index to inspect.
+ * @by_labels: Set to the number of queries answered without search.
+ * @by_search: Set to the number of queries that needed the fallback
+ *	       search.
+ *
+ * Returns: Nothing.
+ */
+void reach_index_counts(const reach_index *idx, long *by_labels,
+			long *by_search)
+{
+	*by_labels = idx->by_labels;
+	*by_search = idx->by_search;
+}
+
+/**
+ * reach_index_kill() - Destroy a given index.
+ * @idx: Index to destroy.
+ *
+ * Returns: Nothing.
+ */
+void reach_index_kill(reach_index *idx)
+{
+	free(idx->comp);
+	free(idx->cyclic);
+	free(idx->dag_offsets);
+	free(idx->dag_targets);
+	free(idx->level);
+	free(idx->low);
+	free(idx->rank);
+	free(idx->stamp);
+	free(idx->stack);
+	free(idx);
+}
@@ -0,0 +1,85 @@
+#ifndef __REACH_INDEX_H
+#define __REACH_INDEX_H
+
+#include <stdbool.h>
+#include "csr.h"
+
+/*
+ * Declaration of a precomputed reachability index for a CSR snapshot
+ * of a graph (see csr.h). The index collapses every strongly connected
+ * component to one vertex of the condensation DAG, and labels each DAG
+ * vertex with a topological level and a few GRAIL interval labels
+ * (Yildirim et al., "GRAIL: Scalable Reachability Index for Large
+ * Graphs", VLDB 2010).
+ *
+ * Queries between nodes of the same component, and most queries that
+ * have no path, are answered from the labels in constant time. The
+ * rest are answered by a depth-first search on the DAG that is pruned
+ * by the labels.
+ *
+ * As for csr_reach(), a node counts as reachable from a source if there
+ * is a path of at least one edge to it. After use, the function
+ * reach_index_kill() must be called to de-allocate the dynamic memory
+ * used by the index.
+ */
+
+// ==========PUBLIC DATA TYPES============
+
+// Index type.
+typedef struct reach_index reach_index;
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * reach_index_build() - Build a reachability index for a snapshot.
+ * @c: Snapshot to index. Must outlive the index.
+ * @num_labels: Number of interval labels per DAG vertex, at least 1.
+ *
+ * Returns: A pointer to the new index.
+ */
+reach_index *reach_index_build(const csr_graph *c, int num_labels);
+
+/**
+ * reach_index_query() - See if a path exists between two nodes.
+ * @idx: Index to use.
+ * @src: Id of the source node.
+ * @dest: Id of the destination node.
+ *
+ * NOTE: The index keeps scratch space for the fallback search, so
+ * queries on the same index must not run concurrently.
+ *
+ * Returns: True if dest can be reached from src by a path of at least
+ * one edge, otherwise false.
+ */
+bool reach_index_query(reach_index *idx, int src, int dest);
+
+/**
+ * reach_index_num_components() - Return the number of strongly connected
+ *				  components of the indexed snapshot.
+ * @idx: Index to inspect.
+ *
+ * Returns: The number of vertices of the condensation DAG.
+ */
+int reach_index_num_components(const reach_index *idx);
+
+/**
+ * reach_index_counts() - Return how the queries so far were answered.
+ * @idx: Index to inspect.
+ * @by_labels: Set to the number of queries answered without search.
+ * @by_search: Set to the number of queries that needed the fallback
+ *	       search.
+ *
+ * Returns: Nothing.
+ */
+void reach_index_counts(const reach_index *idx, long *by_labels,
+			long *by_search);
+
+/**
+ * reach_index_kill() - Destroy a given index.
+ * @idx: Index to destroy.
+ *
+ * Returns: Nothing.
+ */
+void reach_index_kill(reach_index *idx);
+
+#endif
@@ -0,0 +1,190 @@
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reorder.h"
+
+/*
+ * Implementation of locality-improving node orders on a CSR snapshot.
+ */
+
+// ===========INTERNAL DATA TYPES============
+
+/*
+ * Nodes are sorted by keys that pack the sort field into the high half
+ * and the id into the low half, so ties keep the id order and one qsort
+ * of 64-bit words does the work. The field is at least 0.
+ */
+#define KEY(field, id) (((uint64_t)(field) << 32) | (uint32_t)(id))
+#define KEY_ID(key) ((int)(uint32_t)(key))
+
+// ===========INTERNAL FUNCTION IMPLEMENTATIONS============
+
+/**
+ * compare_keys() - qsort comparator of packed sort keys.
+ * @a: First key.
+ * @b: Second key.
+ *
+ * Returns: Negative, zero or positive as a is before, with or after b.
+ */
+static int compare_keys(const void *a, const void *b)
+{
+	uint64_t k1 = *(const uint64_t *)a;
+	uint64_t k2 = *(const uint64_t *)b;
+	return (k1 > k2) - (k1 < k2);
+}
+
+/**
+ * degree() - Return the number of edges at a node, in and out.
+ * @c: Snapshot to inspect.
+ * @v: Id of the node.
+ *
+ * Returns: The degree of v.
+ */
+static int degree(const csr_graph *c, int v)
+{
+	return c->offsets[v + 1] - c->offsets[v]
+		+ c->in_offsets[v + 1] - c->in_offsets[v];
+}
+
+/**
+ * sort_by_degree() - Sort node ids by degree, ties by id.
+ * @c: Snapshot to inspect.
+ * @ids: Ids to sort.
+ * @n: Number of ids.
+ * @keys: Scratch space for n keys.
+ * @descending: If true, the largest degree comes first.
+ *
+ * Returns: Nothing.
+ */
+static void sort_by_degree(const csr_graph *c, int *ids, int n,
+			   uint64_t *keys, bool descending)
+{
+	for (int i = 0; i < n; i++) {
+		int d = degree(c, ids[i]);
+		keys[i] = KEY(descending ? INT_MAX - d : d, ids[i]);
+	}
+	qsort(keys, n, sizeof(*keys), compare_keys);
+	for (int i = 0; i < n; i++) {
+		ids[i] = KEY_ID(keys[i]);
+	}
+}
+
+/**
+ * visit() - Append the unvisited neighbours of a node to an order.
+ * @c: Snapshot to inspect.
+ * @u: Id of the node.
+ * @visited: Flag of each node, set for the appended ones.
+ * @ids: Order to append to.
+ * @tail: Length of the order.
+ *
+ * Returns: The new length of the order.
+ */
+static int visit(const csr_graph *c, int u, bool *visited, int *ids,
+		 int tail)
+{
+	for (int k = c->offsets[u]; k < c->offsets[u + 1]; k++) {
+		int v = c->targets[k];
+		if (!visited[v]) {
+			visited[v] = true;
+			ids[tail++] = v;
+		}
+	}
+	for (int k = c->in_offsets[u]; k < c->in_offsets[u + 1]; k++) {
+		int v = c->sources[k];
+		if (!visited[v]) {
+			visited[v] = true;
+			ids[tail++] = v;
+		}
+	}
+	return tail;
+}
+
+/**
+ * breadth_first() - Order nodes by breadth-first searches.
+ * @c: Snapshot to inspect.
+ * @starts: Ids of all nodes, in the order they are tried as the start
+ * of a new search.
+ * @n: Number of nodes.
+ * @sorted: If true, the neighbours found from each node are sorted by
+ * increasing degree, as by Cuthill-McKee.
+ * @ids: Filled in with the n ids in the order they were visited.
+ * @keys: Scratch space for n keys.
+ *
+ * The order is its own queue, the nodes from ids[head] on are still to
+ * be expanded.
+ *
+ * Returns: Nothing.
+ */
+static void breadth_first(const csr_graph *c, const int *starts, int n,
+			  bool sorted, int *ids, uint64_t *keys)
+{
+	bool *visited = calloc(c->num_nodes + 1, sizeof(*visited));
+	int head = 0;
+	int tail = 0;
+	for (int i = 0; i < n; i++) {
+		if (visited[starts[i]]) {
+			continue;
+		}
+		visited[starts[i]] = true;
+		ids[tail++] = starts[i];
+		while (head < tail) {
+			int first = tail;
+			tail = visit(c, ids[head++], visited, ids, tail);
+			if (sorted) {
+				sort_by_degree(c, ids + first, tail - first,
+					       keys, false);
+			}
+		}
+	}
+	free(visited);
+}
+
+/**
+ * reorder_nodes() - Compute an order of the nodes of a snapshot.
+ * @c: Snapshot to inspect.
+ * @order: Kind of order, see graph_order in graph.h.
+ * @count: Set to the number of nodes in the order.
+ *
+ * Returns: An array of count ids, the old id of each new position. Must
+ * be freed after use.
+ */
+int *reorder_nodes(const csr_graph *c, graph_order order, int *count)
+{
+	int *live = malloc((c->num_nodes + 1) * sizeof(*live));
+	int n = 0;
+	for (int i = 0; i < c->num_nodes; i++) {
+		if (c->nodes[i] != NULL) {
+			live[n++] = i;
+		}
+	}
+	int *ids = malloc((n + 1) * sizeof(*ids));
+	uint64_t *keys = malloc((n + 1) * sizeof(*keys));
+
+	switch (order) {
+	case GRAPH_ORDER_BFS:
+		breadth_first(c, live, n, false, ids, keys);
+		break;
+	case GRAPH_ORDER_RCM:
+		// each component starts from its node of least degree, and
+		// the Cuthill-McKee order is reversed at the end
+		sort_by_degree(c, live, n, keys, false);
+		breadth_first(c, live, n, true, ids, keys);
+		for (int i = 0, j = n - 1; i < j; i++, j--) {
+			int t = ids[i];
+			ids[i] = ids[j];
+			ids[j] = t;
+		}
+		break;
+	default:
+		memcpy(ids, live, n * sizeof(*ids));
+		sort_by_degree(c, ids, n, keys, true);
+		break;
+	}
+
+	free(keys);
+	free(live);
+	*count = n;
+	return ids;
+}
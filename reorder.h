@@ -0,0 +1,32 @@
+#ifndef __REORDER_H
+#define __REORDER_H
+
+#include "csr.h"
+
+/*
+ * Declaration of node orders that improve the memory locality of
+ * traversals. An order lists the node ids of a CSR snapshot so that
+ * nodes that are visited together get nearby positions. The edges are
+ * taken in both directions, so an order does not depend on which way
+ * the routes of a map are listed.
+ *
+ * graph_reorder() renumbers the nodes of a graph by such an order.
+ */
+
+// ==========DATA STRUCTURE INTERFACE==========
+
+/**
+ * reorder_nodes() - Compute an order of the nodes of a snapshot.
+ * @c: Snapshot to inspect.
+ * @order: Kind of order, see graph_order in graph.h.
+ * @count: Set to the number of nodes in the order.
+ *
+ * Ids of deleted nodes, which have NULL in c->nodes, are left out, every
+ * other id appears exactly once.
+ *
+ * Returns: An array of count ids, the old id of each new position. Must
+ * be freed after use.
+ */
+int *reorder_nodes(const csr_graph *c, graph_order order, int *count);
+
+#endif